@@ -0,0 +1,167 @@
+/*
+ * EVTCompressTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ *
+ * Host round trip test and benchmark for EVTCompress.c.
+ * Blocks are built like the ones DrainWriteQueue() hands to EVTCompressBlock(): standard blocks
+ *  (8 byte events, 8 byte planes), compact blocks (one plane), and random bytes which should come
+ *  out stored. Every block has to come back exactly from EVTDecompressBlock(), and a block with a
+ *  flipped bit must never come back as good data.
+ * The benchmark codes full standard blocks of the size a DAQ run writes by default
+ *  (EVT_DEFAULT_BATCH_BUFFERS DMA buffers of VALID_BUFFER_SIZE events) and prints how many events per
+ *  second the encoder handles on this machine. This is only a host number, the rate on the Cortex-A9
+ *  comes from stage 6 (DAQ_STAGE_COMPRESS, the line starting "6_") of the MNS_PROFILE report, see
+ *  reportProfile().
+ *
+ * This is not part of the SDK build (the SDK builds everything in src/), build and run it on the host:
+ *  cd MNS_XQ_Pulser_Test/host_tests
+ *  gcc -std=gnu99 -O2 -I../src -I../../MNS_XQ_Pulser_Test_bsp/ps7_cortexa9_0/include EVTCompressTest.c ../src/EVTCompress.c -o EVTCompressTest
+ *  ./EVTCompressTest
+ *
+ * Returns 0 if every block made the round trip.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "EVTCompress.h"
+#include "lunah_defines.h"
+
+#define TEST_EVENTS			(EVT_DEFAULT_BATCH_BUFFERS * VALID_BUFFER_SIZE)	//events in a default EVT block
+#define TEST_BLOCK_BYTES	(8 + TEST_EVENTS * 8)
+#define TEST_TRIALS			20000
+#define BENCH_BLOCKS		5000
+
+static unsigned char m_raw[TEST_BLOCK_BYTES];
+static unsigned char m_out[TEST_BLOCK_BYTES + sizeof(EVT_COMPRESS_HEADER_TYPE)];
+static unsigned char m_back[TEST_BLOCK_BYTES];
+
+/*
+ * Fill m_raw with an EVT block of num_events events, laid out like the standard EVT event:
+ *  0xFF, PMT and event number, energy and PSD bins, tag, 24 bit time.
+ *
+ * @return	(unsigned int) the bytes in the block
+ */
+static unsigned int BuildStandardBlock( int num_events, unsigned int * time )
+{
+	unsigned char * event = NULL;
+	unsigned int energy = 0;
+	unsigned int psd = 0;
+	int iter = 0;
+
+	m_raw[0] = m_raw[1] = m_raw[2] = m_raw[3] = 0xBB;
+	memcpy(&m_raw[4], &num_events, 4);
+	for(iter = 0; iter < num_events; iter++)
+	{
+		event = &m_raw[8 + iter * 8];
+		*time += rand() % 40;
+		energy = rand() % 512;
+		psd = rand() % 64;
+		event[0] = 0xFF;
+		event[1] = (unsigned char)((1 << (4 + rand() % 4)) | ((iter >> 8) & 0x0F));
+		event[2] = (unsigned char)iter;
+		event[3] = (unsigned char)(energy >> 1);
+		event[4] = (unsigned char)(((energy & 1) << 7) | (psd << 1) | (rand() % 16 == 0));
+		event[5] = (unsigned char)(*time >> 16);
+		event[6] = (unsigned char)(*time >> 8);
+		event[7] = (unsigned char)*time;
+	}
+
+	return 8 + num_events * 8;
+}
+
+/*
+ * Compress m_raw, unpack it again, and check it against the original.
+ *
+ * @return	(unsigned int) the compressed size, 0 if the round trip failed
+ */
+static unsigned int RoundTrip( unsigned int raw_bytes, unsigned int stride )
+{
+	unsigned int comp_bytes = 0;
+
+	comp_bytes = EVTCompressBlock(m_raw, raw_bytes, stride, m_out, sizeof(m_out));
+	if(comp_bytes == 0 || comp_bytes > raw_bytes + sizeof(EVT_COMPRESS_HEADER_TYPE))
+		return 0;
+	memset(m_back, 0, sizeof(m_back));
+	if(EVTDecompressBlock(m_out, comp_bytes, m_back, sizeof(m_back)) != raw_bytes)
+		return 0;
+	if(memcmp(m_raw, m_back, raw_bytes) != 0)
+		return 0;
+
+	return comp_bytes;
+}
+
+int main( void )
+{
+	unsigned long long raw_total = 0;
+	unsigned long long comp_total = 0;
+	unsigned int raw_bytes = 0;
+	unsigned int comp_bytes = 0;
+	unsigned int time = 0;
+	unsigned int failures = 0;
+	unsigned int undetected = 0;
+	unsigned int flip = 0;
+	struct timespec start;
+	struct timespec end;
+	double seconds = 0.0;
+	int trial = 0;
+	int mode = 0;
+	int iter = 0;
+
+	srand(1);
+	for(trial = 0; trial < TEST_TRIALS; trial++)
+	{
+		mode = trial % 3;
+		if(mode == 2)
+		{
+			//random bytes, these should not compress and have to be stored
+			raw_bytes = 1 + rand() % TEST_BLOCK_BYTES;
+			for(iter = 0; iter < (int)raw_bytes; iter++)
+				m_raw[iter] = (unsigned char)rand();
+		}
+		else
+			raw_bytes = BuildStandardBlock(1 + rand() % TEST_EVENTS, &time);
+
+		//standard blocks have one plane per event byte, compact blocks are coded as one plane
+		comp_bytes = RoundTrip(raw_bytes, mode == 1 ? 1 : 8);
+		if(comp_bytes == 0)
+		{
+			if(failures < 10)
+				printf("round trip failed: trial %d, %u bytes\n", trial, raw_bytes);
+			failures++;
+			continue;
+		}
+		if(mode == 0)
+		{
+			raw_total += raw_bytes;
+			comp_total += comp_bytes;
+		}
+
+		//flip a bit past the header, the checksum (or the decoder) has to catch it
+		if(trial % 7 == 0 && comp_bytes > sizeof(EVT_COMPRESS_HEADER_TYPE))
+		{
+			flip = sizeof(EVT_COMPRESS_HEADER_TYPE) + rand() % (comp_bytes - sizeof(EVT_COMPRESS_HEADER_TYPE));
+			m_out[flip] ^= (unsigned char)(1 << (rand() % 8));
+			if(EVTDecompressBlock(m_out, comp_bytes, m_back, sizeof(m_back)) != 0 && memcmp(m_raw, m_back, raw_bytes) != 0)
+				undetected++;
+		}
+	}
+	printf("round trip: %d blocks, %u failures, %u undetected bit flips, standard blocks to %.3f of their size\n",
+			TEST_TRIALS, failures, undetected, (double)comp_total / (double)raw_total);
+
+	//benchmark, full standard blocks
+	raw_bytes = BuildStandardBlock(TEST_EVENTS, &time);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(trial = 0; trial < BENCH_BLOCKS; trial++)
+		comp_bytes = EVTCompressBlock(m_raw, raw_bytes, 8, m_out, sizeof(m_out));
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) * 1e-9;
+	printf("encode: %.1f MB/s, %.2f Mevents/s, %.2f us per %d event block (host)\n",
+			(double)raw_bytes * BENCH_BLOCKS / seconds / 1e6, (double)TEST_EVENTS * BENCH_BLOCKS / seconds / 1e6,
+			seconds / BENCH_BLOCKS * 1e6, TEST_EVENTS);
+
+	return (failures == 0 && undetected == 0) ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+/*
+ * EventBinningTest.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ *
+ * Host test for EventBinning.c. Checks BinningFindBins() against the double precision formula
+ *  ProcessData() used before the binning module (the four baseline integrals averaged per event,
+ *  then floor(fi / (TWODH_ENERGY_MAX / TWODH_X_BINS)) and floor(psd / (TWODH_PSD_MAX / TWODH_Y_BINS))).
+ * Events are random, and also built to land exactly on (and a few counts either side of) every
+ *  energy and PSD bin edge, which is where the integer path has to hand the event to the double
+ *  path. The number of hand-offs is printed so the fallback is seen to run.
+ *
+ * This is not part of the SDK build (the SDK builds everything in src/), build and run it on the host:
+ *  cd MNS_XQ_Pulser_Test/host_tests
+ *  gcc -std=gnu99 -O2 -I../src -I../../MNS_XQ_Pulser_Test_bsp/ps7_cortexa9_0/include EventBinningTest.c -lm -o EventBinningTest
+ *  ./EventBinningTest
+ *
+ * Returns 0 if every event matched.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//pull in the modules themselves so the integer path can be checked on its own
+#include "../src/BaselineTracker.c"
+#include "../src/EventBinning.c"
+
+static unsigned long m_events_checked;
+static unsigned long m_mismatches;
+static unsigned long m_fallbacks;
+
+/*
+ * The binning as ProcessData() did it before EventBinning.c, with the clamping to the top bins.
+ * The baselines are newest first, a 0 for the oldest means there is only the newest one.
+ */
+static void OriginalBins( const unsigned int * baselines, unsigned int raw_short, unsigned int raw_long, unsigned int raw_full,
+		int * samples, int * energy_bin, int * psd_bin, bool * bad_psd )
+{
+	double bl1 = (double)baselines[0] / (16.0 * samples[0]);
+	double bl2 = (double)baselines[1] / (16.0 * samples[0]);
+	double bl3 = (double)baselines[2] / (16.0 * samples[0]);
+	double bl4 = (double)baselines[3] / (16.0 * samples[0]);
+	double bl_avg = 0.0;
+	double si = 0.0;
+	double li = 0.0;
+	double fi = 0.0;
+	double psd = 0.0;
+
+	if(bl4 == 0.0)
+		bl_avg = bl1;
+	else
+		bl_avg = (bl4 + bl3 + bl2 + bl1) / 4.0;
+	si = ((double)raw_short) / (16.0) - (bl_avg * samples[1]);
+	li = ((double)raw_long) / (16.0) - (bl_avg * samples[2]);
+	fi = ((double)raw_full) / (16.0) - (bl_avg * samples[3]);
+	*bad_psd = FALSE;
+	if( li > 0 && si > 0 && li > si)
+		psd = si / (li - si);
+	else
+	{
+		psd = 1.999;
+		*bad_psd = TRUE;
+	}
+	*energy_bin = (int)floor(fi / ((double)TWODH_ENERGY_MAX / (double)TWODH_X_BINS));
+	*psd_bin = (int)floor(psd / ((double)TWODH_PSD_MAX / (double)TWODH_Y_BINS));
+	if(0 <= *energy_bin && *energy_bin < TWODH_X_BINS)
+		*energy_bin &= 0x01FF;
+	else
+		*energy_bin = 0x01FF;
+	if(0 <= *psd_bin && *psd_bin < TWODH_Y_BINS)
+		*psd_bin &= 0x3F;
+	else
+		*psd_bin = 0x3F;
+}
+
+/*
+ * Out of range bins only have to agree on being out of range, both sides go to the top bin.
+ */
+static int ClampBin( int bin, int num_bins )
+{
+	if(bin < 0 || bin >= num_bins)
+		return num_bins;
+	return bin;
+}
+
+/*
+ * Bin one event both ways and count any difference. The integer path is also checked on its own
+ *  against the double path it falls back to.
+ * The baselines are newest first, they go into the baseline tracker oldest first. If the oldest is
+ *  0, only the newest is used, as for the first events of a run.
+ */
+static void CheckEvent( int * samples, const unsigned int * baselines, unsigned int raw_short, unsigned int raw_long, unsigned int raw_full )
+{
+	unsigned long long baseline_sum = 0;
+	int iter = 0;
+	int energy_bin = 0;
+	int psd_bin = 0;
+	int flags = 0;
+	int ref_energy = 0;
+	int ref_psd = 0;
+	bool ref_bad = FALSE;
+	int fixed_energy = 0;
+	int fixed_psd = 0;
+	bool fixed_bad = FALSE;
+	int double_energy = 0;
+	int double_psd = 0;
+	bool double_bad = FALSE;
+
+	m_events_checked++;
+	BaselineReset();
+	for(iter = (baselines[3] == 0 ? 0 : BASELINE_HISTORY_SIZE - 1); iter >= 0; iter--)
+		baseline_sum = BaselineUpdate(0, baselines[iter]);
+	flags = BinningFindBins(0, baseline_sum, raw_short, raw_long, raw_full, &energy_bin, &psd_bin);
+	OriginalBins(baselines, raw_short, raw_long, raw_full, samples, &ref_energy, &ref_psd, &ref_bad);
+	if(energy_bin != ref_energy || psd_bin != ref_psd || ((flags & BINNING_BAD_PSD) != 0) != ref_bad)
+	{
+		if(m_mismatches < 10)
+			printf("mismatch: samples %d %d %d %d baseline %llu raw %u %u %u: got %d %d, formula %d %d\n",
+					samples[0], samples[1], samples[2], samples[3], baseline_sum, raw_short, raw_long, raw_full,
+					energy_bin, psd_bin, ref_energy, ref_psd);
+		m_mismatches++;
+	}
+
+	fixed_energy = FixedPointBins(&m_binning, baseline_sum, raw_short, raw_long, raw_full, &fixed_psd, &fixed_bad);
+	if(fixed_energy == FIXED_BIN_UNSAFE)
+	{
+		m_fallbacks++;
+		return;
+	}
+	double_energy = DoubleBins(&m_binning, 0, raw_short, raw_long, raw_full, &double_psd, &double_bad);
+	if(ClampBin(fixed_energy, TWODH_X_BINS) != ClampBin(double_energy, TWODH_X_BINS)
+			|| ClampBin(fixed_psd, TWODH_Y_BINS) != ClampBin(double_psd, TWODH_Y_BINS) || fixed_bad != double_bad)
+	{
+		if(m_mismatches < 10)
+			printf("integer path: baseline %llu raw %u %u %u: got %d %d, doubles %d %d\n",
+					baseline_sum, raw_short, raw_long, raw_full, fixed_energy, fixed_psd, double_energy, double_psd);
+		m_mismatches++;
+	}
+}
+
+static unsigned int RandomBelow( unsigned int limit )
+{
+	return (unsigned int)(((unsigned long long)rand() * (RAND_MAX + 1ULL) + rand()) % limit);
+}
+
+int main( void )
+{
+	//baseline, short, long, full integration times in samples
+	int configs[][4] = {
+			{ 38, 73, 169, 1551 },	//the default integration times
+			{ 1, 2, 3, 4 },
+			{ 16, 40, 200, 800 },
+			{ 100, 300, 1000, 8000 },
+			{ 255, 511, 2047, FIXED_POINT_MAX_SAMPLES },
+	};
+	int num_configs = sizeof(configs) / sizeof(configs[0]);
+	int config = 0;
+	int iter = 0;
+	int bin = 0;
+	int delta = 0;
+	unsigned int baselines[4];
+	unsigned int avg = 0;
+	unsigned int d = 0;
+	unsigned long long si = 0;
+	unsigned long long li = 0;
+	unsigned long long raw = 0;
+	int * samples = NULL;
+
+	srand(12345);
+	for(config = 0; config < num_configs; config++)
+	{
+		samples = configs[config];
+		BinningUpdate(samples[0], samples[1], samples[2], samples[3]);
+
+		//random events: baselines around 8000 per sample, energies from below zero to past the 2DH
+		for(iter = 0; iter < 1000000; iter++)
+		{
+			avg = 7000 + RandomBelow(2000);
+			for(bin = 0; bin < 4; bin++)
+				baselines[bin] = 16 * samples[0] * avg + RandomBelow(16 * samples[0] * 50);
+			if(iter % 8 == 0)
+				baselines[3] = 0;	//the first event of the run for this PMT
+			raw = 16ULL * avg * samples[3] + RandomBelow(16 * 1300000) - 16 * 10000;
+			if(raw > 0xFFFFFFFFULL)
+				continue;
+			CheckEvent(samples, baselines,
+					16 * avg * samples[1] + RandomBelow(16 * 200000),
+					16 * avg * samples[2] + RandomBelow(16 * 400000),
+					(unsigned int)raw);
+		}
+
+		//events exactly on each energy bin edge and a few counts either side, the baseline is a
+		// whole number per sample so both formulas are exact and have to agree on the edge
+		avg = 8000;
+		for(bin = 0; bin < 4; bin++)
+			baselines[bin] = 16 * samples[0] * avg;
+		for(bin = 0; bin <= TWODH_X_BINS; bin++)
+		{
+			for(delta = -2; delta <= 2; delta++)
+			{
+				//fi = raw/16 - avg * full = bin * 2343.75
+				raw = 37500ULL * bin + 16ULL * avg * samples[3] + delta;
+				if(raw > 0xFFFFFFFFULL)
+					continue;
+				CheckEvent(samples, baselines, 16 * avg * samples[1] + 16 * 1000, 16 * avg * samples[2] + 16 * 5000, (unsigned int)raw);
+			}
+		}
+
+		//events exactly on each PSD bin edge, si / (li - si) = bin / 32
+		for(bin = 0; bin <= TWODH_Y_BINS; bin++)
+		{
+			for(delta = -2; delta <= 2; delta++)
+			{
+				d = 1 + RandomBelow(3000);
+				si = (unsigned long long)bin * d;
+				li = si + 32ULL * d;
+				CheckEvent(samples, baselines,
+						(unsigned int)(16 * (si + (unsigned long long)avg * samples[1]) + delta),
+						(unsigned int)(16 * (li + (unsigned long long)avg * samples[2])),
+						16 * avg * samples[3] + 16 * 100000);
+			}
+		}
+	}
+
+	printf("%lu events checked, %lu handed to the double path, %lu mismatches\n", m_events_checked, m_fallbacks, m_mismatches);
+	return m_mismatches == 0 ? 0 : 1;
+}
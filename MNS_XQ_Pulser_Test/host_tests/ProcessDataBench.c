@@ -0,0 +1,188 @@
+/*
+ * ProcessDataBench.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ *
+ * Host benchmark for the event decode in ProcessData(). Buffers are built like the ones the DMA
+ *  lands: back to back data events with increasing times and event numbers. The noisy buffers also
+ *  have a junk word in front of about 3% of the events, so the resync path runs too.
+ * Each buffer set is run BENCH_REPS times, and the best run is reported. EVT blocks are filled
+ *  EVT_DEFAULT_BATCH_BUFFERS buffers at a time, as in a DAQ run.
+ *
+ * This is how the well-formed event pre-scan (CountWellFormedEvents()) was judged. It was dropped
+ *  in fdd038f, so the tree before that commit still has it. To compare, build this file the same
+ *  way in both trees and run each build a few times:
+ *  git worktree add ../../../prescan fdd038f^
+ *  cp ProcessDataBench.c ../../../prescan/MNS_XQ_Pulser_Test/host_tests/
+ * On x86 the difference was inside the run to run spread.
+ * This is only a host number, the Cortex-A9 rate comes from stage 0 (DAQ_STAGE_PROCESS) of the
+ *  MNS_PROFILE report, see reportProfile().
+ *
+ * This is not part of the SDK build (the SDK builds everything in src/), build and run it on the host:
+ *  cd MNS_XQ_Pulser_Test/host_tests
+ *  gcc -std=gnu99 -O2 -I../src -I../../MNS_XQ_Pulser_Test_bsp/ps7_cortexa9_0/include ProcessDataBench.c
+ *  	../src/process_data.c ../src/CPSDataProduct.c ../src/TwoDHisto.c ../src/EventBinning.c
+ *  	../src/BaselineTracker.c ../src/SPSCRing.c -lm -o ProcessDataBench
+ *  ./ProcessDataBench
+ *
+ * Returns 0 if every buffer decoded the events it was built with (counted from the EVT block, the
+ *  timing includes building it).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "process_data.h"
+
+#define BENCH_BUFFERS		64		//distinct buffers, cycled through
+#define BENCH_PASSES		20		//times through the buffer set per run
+#define BENCH_REPS			5		//runs, the best one is reported
+#define BENCH_JUNK_PERCENT	3		//chance of a junk word in front of an event, noisy buffers
+
+static unsigned int m_buffers[BENCH_BUFFERS][DATA_BUFFER_SIZE];
+static unsigned int m_buffer_events[BENCH_BUFFERS];
+static CONFIG_STRUCT_TYPE m_config;
+
+//the rest of the firmware that the decode modules call, none of it matters for the decode
+CONFIG_STRUCT_TYPE * GetConfigBuffer( void ) { return &m_config; }
+char * GetFileName( int file_type ) { (void)file_type; return "bench"; }
+int GetModuTemp( void ) { return 20; }
+int IncNeutronTotal( int pmt_id, int energy_min, int energy_max, int psd_min, int psd_max, unsigned int time ) { return 0; }
+void XTime_GetTime( XTime * time ) { *time = 0; }
+void DAQStatsWordsSkipped( unsigned int words ) { (void)words; }
+FRESULT f_open( FIL * fp, const TCHAR * path, BYTE mode ) { return FR_OK; }
+FRESULT f_close( FIL * fp ) { return FR_OK; }
+FRESULT f_lseek( FIL * fp, DWORD ofs ) { return FR_OK; }
+FRESULT f_write( FIL * fp, const void * buff, UINT btw, UINT * bw ) { *bw = btw; return FR_OK; }
+void xil_printf( const char8 * ctrl1, ... ) { }
+
+/*
+ * The CPS records go to the SD card from the I/O stage, here they are just thrown away.
+ */
+int WriteCPSRecords( int force )
+{
+	SPSC_RING_TYPE * queue = GetCPSRecordQueue();
+
+	while(SPSCRingPeek(queue) != NULL)
+		SPSCRingPop(queue);
+	return CMD_SUCCESS;
+}
+
+/*
+ * Fill the buffers with data events, the integrals in order and the baseline near the one the
+ *  default integration times expect.
+ *
+ * @return	None
+ */
+static void BuildBuffers( int noisy )
+{
+	unsigned int * buffer = NULL;
+	unsigned int time = 1000;
+	unsigned int number = 1;
+	unsigned int baseline = 0;
+	unsigned int short_int = 0;
+	unsigned int long_int = 0;
+	int buff = 0;
+	int iter = 0;
+
+	srand(7);
+	for(buff = 0; buff < BENCH_BUFFERS; buff++)
+	{
+		buffer = m_buffers[buff];
+		m_buffer_events[buff] = 0;
+		iter = 0;
+		while(iter + EVT_EVENT_SIZE <= DATA_BUFFER_SIZE)
+		{
+			if(noisy && rand() % 100 < BENCH_JUNK_PERCENT)
+			{
+				buffer[iter++] = (unsigned int)rand() | 0x80000000;	//never a header word
+				continue;
+			}
+			time += rand() % 20;
+			number++;
+			baseline = 8000 * 16 * 38 / 4 + rand() % 1000;
+			short_int = baseline + 16 * (rand() % 40000) + 1;
+			long_int = short_int + 16 * (rand() % 100000) + 1;
+			buffer[iter++] = 111111;
+			buffer[iter++] = time;
+			buffer[iter++] = 0;
+			buffer[iter++] = (number << 4) | (1u << (rand() % 4));
+			buffer[iter++] = baseline;
+			buffer[iter++] = short_int;
+			buffer[iter++] = long_int;
+			buffer[iter++] = long_int + 16 * (rand() % 1000000) + 1;
+			m_buffer_events[buff]++;
+		}
+		while(iter < DATA_BUFFER_SIZE)
+			buffer[iter++] = 0;
+	}
+}
+
+/*
+ * Decode the buffer set BENCH_REPS times and print the best rate.
+ *
+ * @return	(int) the number of buffers which did not decode all of their events
+ */
+static int RunBench( const char * name )
+{
+	struct timespec start;
+	struct timespec end;
+	double seconds = 0.0;
+	double best = 0.0;
+	unsigned long events = 0;
+	int failures = 0;
+	unsigned int block_events = 0;
+	unsigned int processed = 0;
+	int rep = 0;
+	int pass = 0;
+	int buff = 0;
+
+	for(rep = 0; rep < BENCH_REPS; rep++)
+	{
+		CPSInit();
+		ResetCPSRecordQueue();
+		ResetEventQuality();
+		ResetEVTsIterator();
+		events = 0;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(pass = 0; pass < BENCH_PASSES; pass++)
+		{
+			for(buff = 0; buff < BENCH_BUFFERS; buff++)
+			{
+				if(buff % EVT_DEFAULT_BATCH_BUFFERS == 0)
+					ResetEVTsIterator();
+				block_events = GetEVTsBlock()->header.num_events;
+				ProcessData(m_buffers[buff]);
+				processed = GetEVTsBlock()->header.num_events - block_events;
+				if(rep == 0 && pass == 0 && processed != m_buffer_events[buff])
+					failures++;
+				events += processed;
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) * 1e-9;
+		if(rep == 0 || seconds < best)
+			best = seconds;
+	}
+	printf("%s: %.2f Mevents/s, %lu events per run, best of %d (host)\n", name, (double)events / best / 1e6, events, BENCH_REPS);
+
+	return failures;
+}
+
+int main( void )
+{
+	int failures = 0;
+
+	BinningUpdate(38, 73, 169, 1551);	//the default integration times
+	SetEVTsBatchSize(EVT_DEFAULT_BATCH_BUFFERS);
+
+	BuildBuffers(0);
+	failures += RunBench("clean");
+	BuildBuffers(1);
+	failures += RunBench("noisy");
+	if(failures != 0)
+		printf("%d buffers did not decode every event\n", failures);
+
+	return failures == 0 ? 0 : 1;
+}
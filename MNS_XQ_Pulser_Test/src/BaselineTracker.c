@@ -0,0 +1,118 @@
+/*
+ * BaselineTracker.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ */
+
+#include "BaselineTracker.h"
+
+//File Scope Variables
+static BASELINE_CHANNEL_TYPE m_baseline[BASELINE_NUM_CHANNELS];	//one moving average per PMT, plus the shared channel
+
+/*
+ * Empty the baseline history of every channel. Call this before a run starts.
+ *
+ * @param	None
+ *
+ * @return	None
+ */
+void BaselineReset( void )
+{
+	memset(m_baseline, 0, sizeof(m_baseline));
+	return;
+}
+
+/*
+ * Find the baseline channel for the PMT hit ID of an event.
+ *
+ * @param	(unsigned int) the PMT hit ID, PMT_ID_#
+ *
+ * @return	(int) the channel, 0-3 for a single PMT, BASELINE_CHANNEL_OTHER for anything else
+ */
+int BaselineGetChannel( unsigned int pmt_id )
+{
+	switch(pmt_id)
+	{
+	case PMT_ID_0:
+		return 0;
+	case PMT_ID_1:
+		return 1;
+	case PMT_ID_2:
+		return 2;
+	case PMT_ID_3:
+		return 3;
+	default:
+		return BASELINE_CHANNEL_OTHER;
+	}
+}
+
+/*
+ * Add the raw baseline integral of an event to the moving average of its channel.
+ * Until the channel has seen BASELINE_HISTORY_SIZE events the newest integral is used on its own,
+ *  scaled up so that the sum always stands for BASELINE_HISTORY_SIZE integrals.
+ *
+ * @param	(int) the channel, see BaselineGetChannel()
+ * @param	(unsigned int) the raw baseline integral from the event
+ *
+ * @return	(unsigned long long) the sum of the last BASELINE_HISTORY_SIZE raw baseline integrals,
+ * 			including this one
+ */
+unsigned long long BaselineUpdate( int channel, unsigned int raw_baseline )
+{
+	BASELINE_CHANNEL_TYPE * bl = NULL;
+
+	if(channel < 0 || channel >= BASELINE_NUM_CHANNELS)
+		channel = BASELINE_CHANNEL_OTHER;
+	bl = &m_baseline[channel];
+
+	bl->sum += (unsigned long long)raw_baseline;
+	bl->sum -= (unsigned long long)bl->history[bl->next];
+	bl->history[bl->next] = raw_baseline;
+	bl->next++;
+	if(bl->next >= BASELINE_HISTORY_SIZE)
+		bl->next = 0;
+	if(bl->count < BASELINE_HISTORY_SIZE)
+	{
+		bl->count++;
+		if(bl->count < BASELINE_HISTORY_SIZE)
+			return (unsigned long long)BASELINE_HISTORY_SIZE * (unsigned long long)raw_baseline;
+	}
+
+	return bl->sum;
+}
+
+/*
+ * Get the raw baseline integrals which make up the moving average of a channel, newest first.
+ * EventBinning uses these for the double precision binning, which averages the integrals one at a
+ *  time just as ProcessData() always has.
+ *
+ * @param	(int) the channel, see BaselineGetChannel()
+ * @param	(unsigned int *) filled in with up to BASELINE_HISTORY_SIZE integrals, newest first
+ *
+ * @return	(int) how many integrals were filled in, the newest one is used on its own until the
+ * 			channel has seen BASELINE_HISTORY_SIZE events
+ */
+int BaselineGetHistory( int channel, unsigned int * history )
+{
+	BASELINE_CHANNEL_TYPE * bl = NULL;
+	int slot = 0;
+	int iter = 0;
+
+	if(channel < 0 || channel >= BASELINE_NUM_CHANNELS)
+		channel = BASELINE_CHANNEL_OTHER;
+	bl = &m_baseline[channel];
+
+	slot = bl->next;
+	for(iter = 0; iter < bl->count; iter++)
+	{
+		if(slot == 0)
+			slot = BASELINE_HISTORY_SIZE;
+		slot--;
+		history[iter] = bl->history[slot];
+	}
+	if(bl->count < BASELINE_HISTORY_SIZE)
+		return 1;
+
+	return BASELINE_HISTORY_SIZE;
+}
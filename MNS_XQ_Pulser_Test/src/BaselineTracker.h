@@ -0,0 +1,38 @@
+/*
+ * BaselineTracker.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ *
+ * Keeps the moving average of the raw baseline integral for each PMT over the whole DAQ run.
+ * Each channel holds the last BASELINE_HISTORY_SIZE raw baseline integrals and their running
+ *  sum, so an update is one add and one subtract no matter how long the history is. The history
+ *  is kept between buffers, so the first events of a buffer are corrected with the baseline
+ *  from the end of the last one, and each PMT is only corrected with its own baseline.
+ * Reset at the start of each run by CPSInit().
+ */
+
+#ifndef SRC_BASELINETRACKER_H_
+#define SRC_BASELINETRACKER_H_
+
+#include <string.h>
+#include "lunah_defines.h"
+
+#define BASELINE_HISTORY_SIZE	4	//events in the moving average, EventBinning expects four
+#define BASELINE_CHANNEL_OTHER	4	//events with no PMT or more than one PMT hit share a channel
+#define BASELINE_NUM_CHANNELS	5
+
+typedef struct{
+	unsigned int history[BASELINE_HISTORY_SIZE];	//raw baseline integrals, oldest at next
+	unsigned long long sum;							//sum of history
+	int next;										//slot the next integral goes in
+	int count;										//integrals seen, stops at BASELINE_HISTORY_SIZE
+}BASELINE_CHANNEL_TYPE;
+
+// prototypes
+void BaselineReset( void );
+int BaselineGetChannel( unsigned int pmt_id );
+unsigned long long BaselineUpdate( int channel, unsigned int raw_baseline );
+int BaselineGetHistory( int channel, unsigned int * history );
+
+#endif /* SRC_BASELINETRACKER_H_ */
@@ -22,6 +22,10 @@ static XTime cps_t_current;	//was LocalTimeCurrent
 static unsigned int m_first_check;
 static int m_current_module_temp;
 
+static unsigned int m_pulser_rate;			//pulses per second injected by the pulser, 0 if there is none
+static unsigned int m_last_live_time_us = CPS_LIVE_TIME_UNKNOWN;	//live time from the most recent finished interval, for SOH
+static unsigned int m_last_dead_fraction = CPS_LIVE_TIME_UNKNOWN;	//dead fraction from the most recent finished interval, for SOH
+
 static double a_rad_1[4];		//semi-major axis
 static double b_rad_1[4];		//semi-minor axis
 static double mean_psd_1[4];	//Y center of the ellipse
@@ -61,6 +65,10 @@ void CPSInit( void )
 	first_FPGA_time = 0;
 	m_previous_1sec_interval_time = 0;
 	m_num_intervals_elapsed = 0;
+	m_last_live_time_us = CPS_LIVE_TIME_UNKNOWN;
+	m_last_dead_fraction = CPS_LIVE_TIME_UNKNOWN;
+	//the event baselines start over with each run
+	BaselineReset();
 	//get the user-supplied neutron cuts
 	m_cfg_buff = *GetConfigBuffer();
 	m_current_module_temp = GetModuTemp();
@@ -188,10 +196,89 @@ CPS_EVENT_STRUCT_TYPE * cpsGetEvent( void )
 	cpsEvent.pad_byte_1 = 0x55;	//use the APID for CPS
 	cpsEvent.pad_byte_2 = 0x55;	//use the APID for CPS
 	cpsEvent.time = m_previous_1sec_interval_time;
+	//live time from the pulser events which made it through, against the ones which were injected
+	//an interval with no data and no pulses says nothing about the live time (no events came in at
+	// all, or the run hadn't reached it yet), so it is reported as unknown rather than 100% dead
+	if(m_pulser_rate == 0 || (cpsEvent.pulser_counts == 0 && cpsEvent.event_counts == 0))
+	{
+		cpsEvent.live_time_us = CPS_LIVE_TIME_UNKNOWN;
+		cpsEvent.dead_fraction = CPS_LIVE_TIME_UNKNOWN;
+	}
+	else if(cpsEvent.pulser_counts >= m_pulser_rate)
+	{
+		cpsEvent.live_time_us = 1000000;
+		cpsEvent.dead_fraction = 0;
+	}
+	else
+	{
+		cpsEvent.live_time_us = (unsigned int)(((unsigned long long)cpsEvent.pulser_counts * 1000000) / m_pulser_rate);
+		cpsEvent.dead_fraction = CPS_DEAD_FRACTION_SCALE - (cpsEvent.pulser_counts * CPS_DEAD_FRACTION_SCALE) / m_pulser_rate;
+	}
+	m_last_live_time_us = cpsEvent.live_time_us;
+	m_last_dead_fraction = cpsEvent.dead_fraction;
 
 	return &cpsEvent;
 }
 
+/*
+ * Set the rate the pulser injects events at. This is latched from DAQ_OPT_PULSER_RATE at the
+ *  start of each DAQ run.
+ *
+ * @param	(int) pulses per second, 0 if there is no pulser
+ *
+ * @return	None
+ */
+void CPSSetPulserRate( int pulses_per_sec )
+{
+	if(pulses_per_sec < 0 || pulses_per_sec > PULSER_MAX_RATE)
+		pulses_per_sec = PULSER_DEFAULT_RATE;
+	m_pulser_rate = (unsigned int)pulses_per_sec;
+	return;
+}
+
+/*
+ * Count a data event (111111 header) in the current 1 second interval, whether or not it ends up in
+ *  one of the tallies.
+ */
+void CPSAddDataEvent( void )
+{
+	cpsEvent.event_counts++;
+	return;
+}
+
+/*
+ * Count a pulser event (0x4001B207) in the current 1 second interval.
+ */
+void CPSAddPulserEvent( void )
+{
+	cpsEvent.pulser_counts++;
+	return;
+}
+
+/*
+ * Getter function for the live time of the most recent finished CPS interval.
+ *
+ * @param	None
+ *
+ * @return	(unsigned int) microseconds live out of the interval, CPS_LIVE_TIME_UNKNOWN without a pulser rate
+ */
+unsigned int CPSGetLiveTime( void )
+{
+	return m_last_live_time_us;
+}
+
+/*
+ * Getter function for the dead fraction of the most recent finished CPS interval.
+ *
+ * @param	None
+ *
+ * @return	(unsigned int) the dead fraction in 1/CPS_DEAD_FRACTION_SCALE, CPS_LIVE_TIME_UNKNOWN without a pulser rate
+ */
+unsigned int CPSGetDeadFraction( void )
+{
+	return m_last_dead_fraction;
+}
+
 /*
  * Helper function which takes in the energy, psd, module number, and the ellipse numbers and calculates the
  *  equations for the ellipses. Then it does the comparison to see if the point (energy, psd) is within the
@@ -359,8 +446,8 @@ int CPSUpdateTallies(int energy_bin, int psd_bin, int pmt_id)
 				MinPSD = MinPSD_C0[MNS_DETECTOR_NUM][iter] + MinPSD_C1[MNS_DETECTOR_NUM][iter]*m_current_module_temp + MinPSD_C2[MNS_DETECTOR_NUM][iter]*m_current_module_temp*m_current_module_temp;
 				MaxPSD = MaxPSD_C0[MNS_DETECTOR_NUM][iter] + MaxPSD_C1[MNS_DETECTOR_NUM][iter]*m_current_module_temp + MaxPSD_C2[MNS_DETECTOR_NUM][iter]*m_current_module_temp*m_current_module_temp;
 
-				MinPSD *= (double)TWODH_Y_BINS / (double)TWODH_PSD_MAX;
-				MaxPSD *= (double)TWODH_Y_BINS / (double)TWODH_PSD_MAX;
+				MinPSD *= BinningGetPSDBinsPerUnit();
+				MaxPSD *= BinningGetPSDBinsPerUnit();
 				//calculate the parameters
 				//will need to modify these parameters with the scale factor & offset values from setIntstrumentParams
 				a_rad_1[iter] =	 (MaxNRG - MinNRG) / 2.0;	// a, semi-major axis
@@ -11,6 +11,8 @@
 #include <stdbool.h>
 #include "lunah_utils.h"	//access to module temp
 #include "SetInstrumentParam.h"	//access to the neutron cuts
+#include "EventBinning.h"		//bin space for the neutron cuts
+#include "BaselineTracker.h"	//reset with the CPS data product
 
 /*
  * This is the CPS event structure and has the follow data fields:
@@ -24,8 +26,13 @@
  * 	non_n_events 	= events which are outside both ellipses are classified as non-neutron events
  * 	high_energy_events = events with an energy above our dynamic range
  *  ---------- Per-module numbers
- *  event_counts 	= total number of event windows opened by the FPGA in the current 1-second interval
+ *  event_counts 	= total number of data events seen in the current 1-second interval
  *  time	 		= FPGA time from the beginning of the current 1s interval (extremely important!!!)
+ *  pulser_counts	= pulser events seen in the current 1-second interval
+ *  live_time_us	= microseconds of the interval we were live for, from the pulser counts
+ *  dead_fraction	= fraction of the interval we were dead for, in 1/CPS_DEAD_FRACTION_SCALE
+ *  				  live_time_us and dead_fraction are CPS_LIVE_TIME_UNKNOWN without a pulser rate (DAQ_OPT_PULSER_RATE),
+ *  				  or for an interval with no data events and no pulser events
  *
  * There is one set of per-module numbers reported for each PMT, they are numbered 0-3
  *
@@ -53,6 +60,9 @@ typedef struct {
 	unsigned int high_energy_events_3;
 	unsigned int event_counts;
 	unsigned int time;
+	unsigned int pulser_counts;
+	unsigned int live_time_us;
+	unsigned int dead_fraction;
 }CPS_EVENT_STRUCT_TYPE;
 
 //Function Prototypes
@@ -67,6 +77,11 @@ float convertToSeconds( unsigned int time );
 unsigned int convertToCycles( float time );
 bool cpsCheckTime( unsigned int time );
 CPS_EVENT_STRUCT_TYPE * cpsGetEvent( void );
+void CPSSetPulserRate( int pulses_per_sec );
+void CPSAddDataEvent( void );
+void CPSAddPulserEvent( void );
+unsigned int CPSGetLiveTime( void );
+unsigned int CPSGetDeadFraction( void );
 bool CPSIsWithinEllipse( int energy, int psd, int pmt_id, int module_num, int ellipse_num );
 int CPSUpdateTallies(int energy_bin, int psd_bin, int pmt_id);
 
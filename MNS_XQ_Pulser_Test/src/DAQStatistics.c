@@ -0,0 +1,228 @@
+/*
+ * DAQStatistics.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ */
+
+#include "DAQStatistics.h"
+
+//File Scope Variables
+static DAQ_STATISTICS_TYPE m_daq_stats;		//accounting for the current (or most recent) DAQ run
+static DAQ_STAGE_PROFILE_TYPE m_stage_profile[DAQ_NUM_STAGES];	//timing profile of each DAQ loop stage
+
+/*
+ * Zero the accounting at the start of a DAQ run.
+ * The values are kept after the run ends so that SOH can still report them.
+ */
+void DAQStatsReset( void )
+{
+	DAQ_STATISTICS_TYPE daqStatsEmptyStruct = {};
+	m_daq_stats = daqStatsEmptyStruct;
+	memset(m_stage_profile, 0, sizeof(m_stage_profile));
+	return;
+}
+
+void DAQStatsBufferProcessed( void )
+{
+	m_daq_stats.buffers_processed++;
+	return;
+}
+
+/*
+ * Called from the acquisition loop when the DMA ring skips a failed or timed out transfer, and from
+ *  DMARingStop() for each buffer left in the ring at the end of the run.
+ */
+void DAQStatsBufferDropped( void )
+{
+	m_daq_stats.buffers_dropped++;
+	return;
+}
+
+/*
+ * Called by the DMA ring once each time the FPGA has valid data and there is no free landing zone.
+ */
+void DAQStatsBufferOverrun( void )
+{
+	m_daq_stats.buffers_overrun++;
+	return;
+}
+
+/*
+ * Record how long the FPGA held valid data before a transfer was started for it.
+ * The DMA ring measures this from the last time it saw valid_data low, or from the end of the
+ *  previous transfer, so it is an upper bound on the time the FPGA waited.
+ *
+ * @param	(XTime) the latency in global timer counts
+ *
+ * @return	None
+ */
+void DAQStatsServiceLatency( XTime latency )
+{
+	m_daq_stats.dead_time += latency;
+	if(latency > m_daq_stats.max_service_latency)
+		m_daq_stats.max_service_latency = latency;
+	return;
+}
+
+/*
+ * Add the time spent in one stage of the DAQ loop.
+ * This also files the time into the profile for that stage.
+ *
+ * @param	(int) the stage, DAQ_STAGE_#
+ * @param	(XTime) the time spent in global timer counts
+ *
+ * @return	None
+ */
+void DAQStatsAddStageTime( int stage, XTime stage_time )
+{
+	int bin = 0;
+	XTime bin_edge = DAQ_PROFILE_BIN_BASE_US * DAQ_TICKS_PER_US;
+	DAQ_STAGE_PROFILE_TYPE * profile = NULL;
+
+	if(stage < 0 || stage >= DAQ_NUM_STAGES)
+		return;
+	m_daq_stats.stage_time[stage] += stage_time;
+
+	profile = &m_stage_profile[stage];
+	if(profile->count == 0 || stage_time < profile->min)
+		profile->min = stage_time;
+	if(stage_time > profile->max)
+		profile->max = stage_time;
+	profile->count++;
+	while(stage_time >= bin_edge && bin < DAQ_PROFILE_BINS - 1)
+	{
+		bin_edge *= 4;
+		bin++;
+	}
+	profile->hist[bin]++;
+
+	return;
+}
+
+/*
+ * Record how many words ProcessData() skipped while resynchronizing in one buffer.
+ * A clean buffer skips none, so anything here means junk or a partial event in the data. The run
+ *  total is kept with the event quality accounting in ProcessData().
+ *
+ * @param	(unsigned int) the words skipped in the buffer
+ *
+ * @return	None
+ */
+void DAQStatsWordsSkipped( unsigned int words )
+{
+	if(words == 0)
+		return;
+	m_daq_stats.buffers_resynced++;
+	if(words > m_daq_stats.max_words_skipped)
+		m_daq_stats.max_words_skipped = words;
+	return;
+}
+
+unsigned int DAQStatsGetBuffersProcessed( void )
+{
+	return m_daq_stats.buffers_processed;
+}
+
+unsigned int DAQStatsGetBuffersDropped( void )
+{
+	return m_daq_stats.buffers_dropped;
+}
+
+unsigned int DAQStatsGetBuffersOverrun( void )
+{
+	return m_daq_stats.buffers_overrun;
+}
+
+unsigned int DAQStatsGetMaxLatencyUs( void )
+{
+	return (unsigned int)(m_daq_stats.max_service_latency / DAQ_TICKS_PER_US);
+}
+
+unsigned int DAQStatsGetDeadTimeMs( void )
+{
+	return (unsigned int)(m_daq_stats.dead_time / DAQ_TICKS_PER_MS);
+}
+
+unsigned int DAQStatsGetMaxWordsSkipped( void )
+{
+	return m_daq_stats.max_words_skipped;
+}
+
+unsigned int DAQStatsGetBuffersResynced( void )
+{
+	return m_daq_stats.buffers_resynced;
+}
+
+/*
+ * Getter function for the CPU time spent in one stage of the DAQ loop.
+ *
+ * @param	(int) the stage, DAQ_STAGE_#
+ *
+ * @return	(unsigned int) the time in milliseconds, 0 if the stage does not exist
+ */
+unsigned int DAQStatsGetStageTimeMs( int stage )
+{
+	if(stage < 0 || stage >= DAQ_NUM_STAGES)
+		return 0;
+	return (unsigned int)(m_daq_stats.stage_time[stage] / DAQ_TICKS_PER_MS);
+}
+
+/*
+ * Getter function for the number of times a stage of the DAQ loop was timed.
+ *
+ * @param	(int) the stage, DAQ_STAGE_#
+ *
+ * @return	(unsigned int) the count, 0 if the stage does not exist
+ */
+unsigned int DAQStatsGetStageCount( int stage )
+{
+	if(stage < 0 || stage >= DAQ_NUM_STAGES)
+		return 0;
+	return m_stage_profile[stage].count;
+}
+
+unsigned int DAQStatsGetStageMinUs( int stage )
+{
+	if(stage < 0 || stage >= DAQ_NUM_STAGES)
+		return 0;
+	return (unsigned int)(m_stage_profile[stage].min / DAQ_TICKS_PER_US);
+}
+
+unsigned int DAQStatsGetStageMaxUs( int stage )
+{
+	if(stage < 0 || stage >= DAQ_NUM_STAGES)
+		return 0;
+	return (unsigned int)(m_stage_profile[stage].max / DAQ_TICKS_PER_US);
+}
+
+/*
+ * Getter function for the mean time of one pass through a stage of the DAQ loop.
+ *
+ * @param	(int) the stage, DAQ_STAGE_#
+ *
+ * @return	(unsigned int) the mean in microseconds, 0 if the stage was never timed
+ */
+unsigned int DAQStatsGetStageMeanUs( int stage )
+{
+	if(stage < 0 || stage >= DAQ_NUM_STAGES || m_stage_profile[stage].count == 0)
+		return 0;
+	return (unsigned int)(m_daq_stats.stage_time[stage] / m_stage_profile[stage].count / DAQ_TICKS_PER_US);
+}
+
+/*
+ * Getter function for one bin of a stage's timing histogram.
+ * Bin 0 counts passes shorter than DAQ_PROFILE_BIN_BASE_US, bin n counts passes shorter than
+ *  DAQ_PROFILE_BIN_BASE_US * 4^n, the last bin counts everything longer.
+ *
+ * @param	(int) the stage, DAQ_STAGE_#
+ * @param	(int) the bin, 0 -> DAQ_PROFILE_BINS - 1
+ *
+ * @return	(unsigned int) the number of passes in the bin, 0 if the stage or bin does not exist
+ */
+unsigned int DAQStatsGetStageHistBin( int stage, int bin )
+{
+	if(stage < 0 || stage >= DAQ_NUM_STAGES || bin < 0 || bin >= DAQ_PROFILE_BINS)
+		return 0;
+	return m_stage_profile[stage].hist[bin];
+}
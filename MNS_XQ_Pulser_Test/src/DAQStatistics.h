@@ -0,0 +1,83 @@
+/*
+ * DAQStatistics.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ *
+ * Dead-time and throughput accounting for a DAQ run. The DMA ring reports how long the FPGA
+ *  held valid data before we serviced it and which buffers were lost, the DAQ loop reports the
+ *  buffers it processed and how long each stage took. The numbers are reported in the EVT and
+ *  CPS file footers and in the SOH packet, so that a drop in the rate can be told apart from the
+ *  flight software falling behind.
+ * Each timed stage also keeps a profile (count, min, max, mean, and a coarse histogram) which may
+ *  be dumped with the MNS_PROFILE command, so the loop can be profiled on the flight hardware
+ *  without a rebuild or any printf traffic.
+ * Everything here is written from the acquisition loop only, never from the interrupt handler, so
+ *  the 64-bit times may be read from the loop (SOH, MNS_PROFILE) without masking interrupts.
+ */
+
+#ifndef SRC_DAQSTATISTICS_H_
+#define SRC_DAQSTATISTICS_H_
+
+#include <string.h>
+#include "xtime_l.h"
+#include "lunah_defines.h"
+
+//DAQ loop stages which are timed
+#define DAQ_STAGE_PROCESS	0	//ProcessData()
+#define DAQ_STAGE_DRAIN		1	//DrainWriteQueue(), the SD card writes
+#define DAQ_STAGE_SOH		2	//CheckForSOH() and polling for commands
+#define DAQ_STAGE_DMA		3	//servicing the DMA ring and collecting a finished buffer
+#define DAQ_STAGE_HANDOFF	4	//raw capture, releasing the landing zone, queueing the EVT block
+#define DAQ_STAGE_LOOP		5	//one whole pass of the DAQ loop which processed a buffer
+#define DAQ_STAGE_COMPRESS	6	//EVTCompressBlock() on one EVT block, this is part of DAQ_STAGE_DRAIN
+#define DAQ_NUM_STAGES		7
+
+//stage profile histogram, bin 0 is < 2us, each bin after is 4x wider, the last bin holds the rest
+#define DAQ_PROFILE_BINS		8
+#define DAQ_PROFILE_BIN_BASE_US	2
+
+#define DAQ_TICKS_PER_US	(COUNTS_PER_SECOND / 1000000)
+#define DAQ_TICKS_PER_MS	(COUNTS_PER_SECOND / 1000)
+
+typedef struct {
+	unsigned int buffers_processed;		//buffers run through ProcessData()
+	unsigned int buffers_dropped;		//buffers lost to DMA errors or time outs
+	unsigned int buffers_overrun;		//times the FPGA had valid data but every landing zone was full
+	XTime max_service_latency;			//longest the FPGA held valid data before a transfer was started
+	XTime dead_time;					//total time the FPGA held valid data waiting on us
+	XTime stage_time[DAQ_NUM_STAGES];	//CPU time spent in each stage of the DAQ loop
+	unsigned int max_words_skipped;		//most words skipped in a single buffer
+	unsigned int buffers_resynced;		//buffers which needed any words skipped
+}DAQ_STATISTICS_TYPE;
+
+typedef struct {
+	unsigned int count;							//times the stage was timed
+	XTime min;
+	XTime max;
+	unsigned int hist[DAQ_PROFILE_BINS];		//see DAQ_PROFILE_BIN_BASE_US
+}DAQ_STAGE_PROFILE_TYPE;
+
+// prototypes
+void DAQStatsReset( void );
+void DAQStatsBufferProcessed( void );
+void DAQStatsBufferDropped( void );
+void DAQStatsBufferOverrun( void );
+void DAQStatsServiceLatency( XTime latency );
+void DAQStatsAddStageTime( int stage, XTime stage_time );
+void DAQStatsWordsSkipped( unsigned int words );
+unsigned int DAQStatsGetBuffersProcessed( void );
+unsigned int DAQStatsGetBuffersDropped( void );
+unsigned int DAQStatsGetBuffersOverrun( void );
+unsigned int DAQStatsGetMaxLatencyUs( void );
+unsigned int DAQStatsGetDeadTimeMs( void );
+unsigned int DAQStatsGetMaxWordsSkipped( void );
+unsigned int DAQStatsGetBuffersResynced( void );
+unsigned int DAQStatsGetStageTimeMs( int stage );
+unsigned int DAQStatsGetStageCount( int stage );
+unsigned int DAQStatsGetStageMinUs( int stage );
+unsigned int DAQStatsGetStageMaxUs( int stage );
+unsigned int DAQStatsGetStageMeanUs( int stage );
+unsigned int DAQStatsGetStageHistBin( int stage, int bin );
+
+#endif /* SRC_DAQSTATISTICS_H_ */
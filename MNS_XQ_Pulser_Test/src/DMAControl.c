@@ -0,0 +1,481 @@
+/*
+ * DMAControl.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ *
+ * The DMA is run in Direct Register Mode with Interrupt on Complete enabled (see InitializeAXIDma()).
+ * A transfer is started by writing the destination address and the length, then the interrupt
+ *  handler flags the transfer as complete when the IOC interrupt fires. The acquisition loops poll
+ *  the flag so that they may check for SOH and user input while the transfer is in flight.
+ *
+ * During DAQ the landing zones are run as a receive ring (see DMARingInit()). The AXI DMA in this
+ *  design is built without the Scatter Gather engine (XPAR_AXI_DMA_0_INCLUDE_SG = 0), so the ring is
+ *  kept in software: the interrupt handler retires the finished descriptor and immediately re-arms the
+ *  engine with the next free landing zone, so the FPGA does not wait on the acquisition loop between
+ *  buffers. The loop consumes the finished descriptors in order.
+ * The interrupt handler only changes descriptor states and re-arms the engine. It takes no time
+ *  stamps and does not touch the DAQ statistics, all of the dead time, overrun, drop, and time out
+ *  accounting is done from DMARingService() and DMARingGetCompleted() in the acquisition loop. This
+ *  keeps the handler short and means the 64-bit statistics are never written behind the loop's back.
+ *
+ * The data cache may be on during a DAQ run (DAQ_OPT_DCACHE), so the landing zones get cache
+ *  maintenance. The CPU never writes to a landing zone, so there are no dirty lines to flush before
+ *  a transfer. After the transfer the zone is invalidated so that any lines pulled in before or
+ *  during the transfer are dropped.
+ */
+
+#include "DMAControl.h"
+
+//File Scope Variables
+static volatile int m_dma_transfer_done;		//set by the interrupt handler when the S2MM transfer completes
+static volatile int m_dma_transfer_error;		//set by the interrupt handler when the DMA reports an error
+static int m_dma_transfer_in_flight;			//a transfer has been started but not finished
+static unsigned int m_dma_dest_addr;			//where the current transfer is landing
+static unsigned int m_dma_timeout_count;		//number of transfers which never reported completion
+static XTime m_dma_start_time;					//when the current transfer was started
+
+static DMA_RING_DESC_TYPE m_ring[DMA_MAX_RING_DEPTH];	//DAQ receive ring, one descriptor per landing zone
+static int m_ring_depth;						//number of descriptors in use for this run
+static int m_ring_active;						//the interrupt handler feeds the ring instead of the single transfer flag
+static volatile int m_ring_stopping;			//DAQ is over, don't arm any more transfers
+static volatile int m_ring_armed;				//the descriptor the DMA is writing, -1 when the engine is idle
+static volatile int m_ring_next_arm;			//next descriptor to hand to the DMA
+static volatile unsigned int m_ring_arm_count;	//transfers started, so the loop can tell when the handler started one
+static unsigned int m_ring_arm_seen;			//m_ring_arm_count when the loop last stamped m_ring_arm_time
+static int m_ring_next_read;					//next descriptor for the CPU to consume, in order
+static XTime m_ring_arm_time;					//when the loop first saw the armed descriptor in flight
+static XTime m_ring_wait_start;					//last time we knew the FPGA was not waiting on us, for DAQ dead time
+static int m_ring_overrun;						//the FPGA is waiting and every landing zone is full
+
+static int DMARingArmNext( void );
+static void DMARingClearBRAM( void );
+static int DMAResetChannel( void );
+
+/*
+ * Called from the DMA interrupt handler after the status register has been read.
+ * This is the only place the completion flag is set, so keep it short.
+ *
+ * @param	(unsigned int) the value of the S2MM status register when the interrupt fired
+ *
+ * @return	none
+ */
+void DMASetTransferComplete( unsigned int status_reg )
+{
+	if(m_ring_active == 1)
+	{
+		if(m_ring_armed >= 0 && (status_reg & (DMA_S2MM_IOC_IRQ | DMA_S2MM_ERR_IRQ)))
+		{
+			//the drop is counted when the loop skips over the descriptor
+			if(status_reg & DMA_S2MM_ERR_IRQ)
+				m_ring[m_ring_armed].state = DMA_DESC_ERROR;
+			else
+				m_ring[m_ring_armed].state = DMA_DESC_DONE;
+			Xil_Out32 (XPAR_AXI_GPIO_15_BASEADDR, 0);
+			DMARingClearBRAM();
+			m_ring_armed = -1;
+			//a DMA error halts the engine, leave it idle and DMARingService() resets it before arming
+			if(!(status_reg & DMA_S2MM_ERR_IRQ))
+				DMARingArmNext();	//keep the FPGA streaming without waiting on the acquisition loop
+		}
+		return;
+	}
+
+	if(status_reg & DMA_S2MM_ERR_IRQ)
+		m_dma_transfer_error = 1;
+	if(status_reg & (DMA_S2MM_IOC_IRQ | DMA_S2MM_ERR_IRQ))
+		m_dma_transfer_done = 1;
+	return;
+}
+
+/*
+ * Start a transfer from the FPGA buffers into DRAM. The caller must have already seen
+ *  valid data from the FPGA (XPAR_AXI_GPIO_11).
+ *
+ * @param	(unsigned int) the DRAM address the data will land at
+ *
+ * @return	none
+ */
+void DMAStartTransfer( unsigned int dest_addr )
+{
+	m_dma_transfer_done = 0;
+	m_dma_transfer_error = 0;
+	m_dma_transfer_in_flight = 1;
+	m_dma_dest_addr = dest_addr;
+	XTime_GetTime(&m_dma_start_time);
+
+	//init/start MUX to transfer data between integrator modules and the DMA
+	Xil_Out32 (XPAR_AXI_GPIO_15_BASEADDR, 1);
+	Xil_Out32 (XPAR_AXI_DMA_0_BASEADDR + DMA_S2MM_DA_OFFSET, dest_addr);
+	Xil_Out32 (XPAR_AXI_DMA_0_BASEADDR + DMA_S2MM_LENGTH_OFFSET, DMA_TRANSFER_SIZE);
+	return;
+}
+
+bool DMAIsTransferInFlight( void )
+{
+	if(m_dma_transfer_in_flight == 1)
+		return TRUE;
+	else
+		return FALSE;
+}
+
+bool DMAIsTransferComplete( void )
+{
+	if(m_dma_transfer_in_flight == 1 && m_dma_transfer_done == 1)
+		return TRUE;
+	else
+		return FALSE;
+}
+
+/*
+ * Check if the transfer in flight has taken longer than it ever should.
+ * If the interrupt was missed, this lets the acquisition loop recover rather than hang.
+ *
+ * @param	none
+ *
+ * @return	TRUE if the transfer has been in flight longer than DMA_TRANSFER_TIMEOUT_US
+ */
+bool DMAHasTransferTimedOut( void )
+{
+	XTime m_current_time;
+
+	if(m_dma_transfer_in_flight != 1)
+		return FALSE;
+	XTime_GetTime(&m_current_time);
+	if((m_current_time - m_dma_start_time) >= (XTime)DMA_TRANSFER_TIMEOUT_US * (COUNTS_PER_SECOND / 1000000))
+		return TRUE;
+	else
+		return FALSE;
+}
+
+/*
+ * Wrap up the transfer which was in flight. This releases the MUX, tells the FPGA we are done
+ *  with the buffer, and invalidates the cache over the landing zone so that we read what the
+ *  DMA wrote and not stale cache lines.
+ * Call this once DMAIsTransferComplete() or DMAHasTransferTimedOut() returns TRUE.
+ *
+ * @param	none
+ *
+ * @return	CMD_SUCCESS if the data in the landing zone is good
+ * 			CMD_FAILURE if the transfer timed out or the DMA reported an error
+ */
+int DMAFinishTransfer( void )
+{
+	int status = CMD_SUCCESS;
+
+	if(m_dma_transfer_done != 1)
+	{
+		m_dma_timeout_count++;
+		xil_printf("DMA transfer timed out\n");
+		//the engine may still be part way through the transfer, stop it before the landing zone is reused
+		if(DMAResetChannel() != CMD_SUCCESS)
+			xil_printf("DMA reset did not finish\n");
+		status = CMD_FAILURE;
+	}
+	else if(m_dma_transfer_error == 1)
+	{
+		xil_printf("DMA transfer error\n");
+		status = CMD_FAILURE;
+	}
+
+	Xil_Out32 (XPAR_AXI_GPIO_15_BASEADDR, 0);
+	ClearBRAMBuffers();
+	Xil_DCacheInvalidateRange(m_dma_dest_addr, DMA_BUFFER_BYTES);	//only invalidate what we are going to read
+	m_dma_transfer_in_flight = 0;
+
+	return status;
+}
+
+/*
+ * Block until the transfer in flight completes (or times out), then finish it.
+ * For loops which have nothing else to do while the transfer runs.
+ *
+ * @param	none
+ *
+ * @return	CMD_SUCCESS/CMD_FAILURE, see DMAFinishTransfer()
+ */
+int DMAWaitForTransfer( void )
+{
+	while(DMAIsTransferComplete() == FALSE && DMAHasTransferTimedOut() == FALSE)
+	{
+		//wait for the interrupt handler
+	}
+
+	return DMAFinishTransfer();
+}
+
+/*
+ * Getter function for the number of transfers which timed out, since DMARingInit() for a DAQ run.
+ *
+ * @param	none
+ *
+ * @return	(unsigned int) the DMA time out count
+ */
+unsigned int DMAGetTimeoutCount( void )
+{
+	return m_dma_timeout_count;
+}
+
+/*
+ * Set up the DAQ receive ring for a run. Each descriptor gets its own landing zone, starting at
+ *  DRAM_BASE and spaced DMA_LANDING_ZONE_STRIDE apart. From here until DMARingStop() the interrupt
+ *  handler re-arms the DMA itself whenever there is a free descriptor and the FPGA has data.
+ *
+ * @param	(int) number of landing zones in the ring, 2 -> DMA_MAX_RING_DEPTH
+ *
+ * @return	CMD_SUCCESS/CMD_FAILURE if the ring depth is out of range
+ */
+int DMARingInit( int ring_depth )
+{
+	int iter = 0;
+
+	if(ring_depth < 2 || ring_depth > DMA_MAX_RING_DEPTH)
+		return CMD_FAILURE;
+
+	for(iter = 0; iter < ring_depth; iter++)
+	{
+		m_ring[iter].addr = DRAM_BASE + (unsigned int)iter * DMA_LANDING_ZONE_STRIDE;
+		m_ring[iter].state = DMA_DESC_FREE;
+	}
+	m_ring_depth = ring_depth;
+	m_ring_armed = -1;
+	m_ring_next_arm = 0;
+	m_ring_next_read = 0;
+	m_ring_stopping = 0;
+	m_ring_overrun = 0;
+	m_ring_arm_count = 0;
+	m_ring_arm_seen = 0;
+	m_dma_timeout_count = 0;	//the count goes in the run footer, see UpdateFooterStatistics()
+	XTime_GetTime(&m_ring_wait_start);
+	m_ring_active = 1;
+
+	return CMD_SUCCESS;
+}
+
+/*
+ * Stop feeding the DAQ receive ring. If a transfer is in flight, let it land first so the
+ *  DMA is idle and the MUX is released before we leave DAQ.
+ * Any buffer still in the ring is thrown away, whether it failed or landed after the loop's last
+ *  look, so it is counted as dropped.
+ */
+void DMARingStop( void )
+{
+	int iter = 0;
+
+	m_ring_stopping = 1;
+	while(m_ring_armed >= 0)
+	{
+		DMARingService();	//either the interrupt handler retires it or the time out does
+	}
+	//the failed transfers and the finished buffers the loop never got to are still drops
+	for(iter = 0; iter < m_ring_depth; iter++)
+	{
+		if(m_ring[iter].state == DMA_DESC_ERROR || m_ring[iter].state == DMA_DESC_DONE)
+		{
+			DAQStatsBufferDropped();
+			m_ring[iter].state = DMA_DESC_FREE;
+		}
+	}
+	m_ring_active = 0;
+	return;
+}
+
+/*
+ * Tell the FPGA we are done with its buffer and to move on to the next one. This is
+ *  ClearBRAMBuffers() without the usleep(1), so it may be used from the interrupt handler. Reading
+ *  the GPIO back waits for the set to reach the FPGA before the clear is written, so the pulse is
+ *  at least one full AXI write wide.
+ */
+static void DMARingClearBRAM( void )
+{
+	Xil_Out32 (XPAR_AXI_GPIO_9_BASEADDR, 1);
+	(void)Xil_In32 (XPAR_AXI_GPIO_9_BASEADDR);
+	Xil_Out32 (XPAR_AXI_GPIO_9_BASEADDR, 0);
+	return;
+}
+
+/*
+ * Soft reset the DMA and start it again with the interrupt on complete enabled, as InitializeAXIDma()
+ *  left it. This stops a transfer which is still running (or hung) and clears its status, so a late
+ *  IOC for it can't retire the next descriptor, and it brings the engine back after a DMA error
+ *  halted it. The reset also covers the MM2S channel, which this design does not use.
+ * The caller must keep the interrupt handler out, or be sure nothing is in flight.
+ *
+ * @param	none
+ *
+ * @return	CMD_SUCCESS/CMD_FAILURE if the reset did not finish in DMA_RESET_TIMEOUT_US
+ */
+static int DMAResetChannel( void )
+{
+	XTime reset_start;
+	XTime m_current_time;
+	int status = CMD_SUCCESS;
+
+	Xil_Out32 (XPAR_AXI_DMA_0_BASEADDR + DMA_S2MM_DMACR_OFFSET, DMA_S2MM_RESET);
+	XTime_GetTime(&reset_start);
+	//the reset bit clears itself once the channel has halted
+	while((Xil_In32 (XPAR_AXI_DMA_0_BASEADDR + DMA_S2MM_DMACR_OFFSET) & DMA_S2MM_RESET)
+			|| !(Xil_In32 (XPAR_AXI_DMA_0_BASEADDR + DMA_S2MM_DMASR_OFFSET) & DMA_S2MM_HALTED))
+	{
+		XTime_GetTime(&m_current_time);
+		if((m_current_time - reset_start) >= (XTime)DMA_RESET_TIMEOUT_US * (COUNTS_PER_SECOND / 1000000))
+		{
+			status = CMD_FAILURE;
+			break;
+		}
+	}
+
+	Xil_Out32 (XPAR_AXI_DMA_0_BASEADDR + DMA_S2MM_DMACR_OFFSET, DMA_S2MM_IOC_IRQ_EN | DMA_S2MM_RUN);
+	(void)Xil_In32 (XPAR_AXI_DMA_0_BASEADDR + DMA_S2MM_DMACR_OFFSET);
+	return status;
+}
+
+/*
+ * Hand the next descriptor in the ring to the DMA if it is free and the FPGA has a buffer for us.
+ * This is called from the interrupt handler when a transfer completes, and from DMARingService()
+ *  when the engine is idle. Those two never overlap: the interrupt only fires while a transfer is
+ *  in flight, and the loop only arms the engine when nothing is in flight.
+ * Keep this to the hand off, the accounting for why the engine was not armed is in DMARingService().
+ *
+ * @return	(int) 1 if a transfer was started, 0 if the engine was left idle
+ */
+static int DMARingArmNext( void )
+{
+	int next = m_ring_next_arm;
+
+	if(m_ring_stopping == 1)
+		return 0;
+	if(Xil_In32 (XPAR_AXI_GPIO_11_BASEADDR) != 1 || m_ring[next].state != DMA_DESC_FREE)
+		return 0;
+
+	m_ring[next].state = DMA_DESC_IN_FLIGHT;
+	m_ring_armed = next;
+	m_ring_next_arm = (next + 1 < m_ring_depth) ? next + 1 : 0;
+	m_ring_arm_count++;
+
+	//init/start MUX to transfer data between integrator modules and the DMA
+	Xil_Out32 (XPAR_AXI_GPIO_15_BASEADDR, 1);
+	Xil_Out32 (XPAR_AXI_DMA_0_BASEADDR + DMA_S2MM_DA_OFFSET, m_ring[next].addr);
+	Xil_Out32 (XPAR_AXI_DMA_0_BASEADDR + DMA_S2MM_LENGTH_OFFSET, DMA_TRANSFER_SIZE);
+	return 1;
+}
+
+/*
+ * Called from the acquisition loop every time around. Starts the engine if it went idle
+ *  (the FPGA had no data when the last transfer finished, or every landing zone was full), and
+ *  retires a transfer which never reported completion so the ring does not stall.
+ * This is also where the DAQ dead time is measured. While a transfer is in flight the FPGA is not
+ *  waiting on us, so the wait is timed from the last pass which saw the engine busy (or saw no
+ *  valid data) to the pass which arms the engine. A transfer the interrupt handler re-armed right
+ *  away has no wait. This is an upper bound on the time the FPGA waited.
+ *
+ * @param	none
+ *
+ * @return	none
+ */
+void DMARingService( void )
+{
+	XTime m_current_time;
+	int timed_out = 0;
+	int reset_status = CMD_SUCCESS;
+
+	XTime_GetTime(&m_current_time);
+	if(m_ring_armed < 0)
+	{
+		//the engine is idle, so the interrupt handler can't run until we arm it
+		if(m_ring_stopping == 1)
+			return;
+		if(Xil_In32 (XPAR_AXI_GPIO_11_BASEADDR) != 1)
+		{
+			//no valid data yet, the FPGA isn't waiting on us
+			m_ring_wait_start = m_current_time;
+			m_ring_overrun = 0;
+			return;
+		}
+		if(m_ring[m_ring_next_arm].state != DMA_DESC_FREE)
+		{
+			//the CPU has not caught up, the FPGA holds onto its buffers until we do
+			if(m_ring_overrun == 0)
+				DAQStatsBufferOverrun();	//count each time we fall behind once, not each time we look
+			m_ring_overrun = 1;
+			return;
+		}
+		DAQStatsServiceLatency(m_current_time - m_ring_wait_start);
+		m_ring_overrun = 0;
+		//a DMA error leaves the channel halted and it won't take a new transfer until it is reset
+		if(Xil_In32 (XPAR_AXI_DMA_0_BASEADDR + DMA_S2MM_DMASR_OFFSET) & DMA_S2MM_HALTED)
+		{
+			if(DMAResetChannel() != CMD_SUCCESS)
+				xil_printf("DMA reset did not finish\n");
+		}
+		if(DMARingArmNext() == 0)
+			return;
+	}
+
+	//a transfer is in flight, either we or the interrupt handler started it
+	if(m_ring_arm_count != m_ring_arm_seen)
+	{
+		m_ring_arm_seen = m_ring_arm_count;
+		m_ring_arm_time = m_current_time;
+	}
+	m_ring_wait_start = m_current_time;
+	if((m_current_time - m_ring_arm_time) >= (XTime)DMA_TRANSFER_TIMEOUT_US * (COUNTS_PER_SECOND / 1000000))
+	{
+		//keep the interrupt handler out while we retire the descriptor ourselves
+		//the handler may have started a new transfer since we looked, that one is not late
+		Xil_ExceptionDisable();
+		if(m_ring_armed >= 0 && m_ring_arm_count == m_ring_arm_seen)
+		{
+			//stop the engine first, a late IOC from this transfer would otherwise mark the next descriptor DONE
+			reset_status = DMAResetChannel();
+			m_ring[m_ring_armed].state = DMA_DESC_ERROR;	//counted as dropped when it is skipped
+			m_ring_armed = -1;
+			m_dma_timeout_count++;
+			Xil_Out32 (XPAR_AXI_GPIO_15_BASEADDR, 0);
+			ClearBRAMBuffers();
+			timed_out = 1;
+		}
+		Xil_ExceptionEnable();
+		if(timed_out == 1)
+			xil_printf("DMA transfer timed out\n");
+		if(reset_status != CMD_SUCCESS)
+			xil_printf("DMA reset did not finish\n");
+	}
+	return;
+}
+
+/*
+ * Get the oldest buffer in the ring that the DMA has finished writing. Descriptors are consumed
+ *  in the order they were armed, failed transfers are skipped over. The landing zone is
+ *  invalidated here (not in the interrupt handler) so that it may be read in place.
+ * Call DMARingRelease() once the buffer is no longer needed.
+ *
+ * @param	none
+ *
+ * @return	(unsigned int *) pointer to the DATA_BUFFER_SIZE words the DMA wrote
+ * 			NULL if the next buffer in order has not landed yet
+ */
+unsigned int * DMARingGetCompleted( void )
+{
+	while(m_ring[m_ring_next_read].state == DMA_DESC_ERROR)
+	{
+		DAQStatsBufferDropped();
+		DMARingRelease();
+	}
+
+	if(m_ring[m_ring_next_read].state != DMA_DESC_DONE)
+		return NULL;
+
+	Xil_DCacheInvalidateRange(m_ring[m_ring_next_read].addr, DMA_BUFFER_BYTES);
+	return (unsigned int *)(UINTPTR)m_ring[m_ring_next_read].addr;
+}
+
+/*
+ * Give the oldest finished landing zone back to the DMA.
+ */
+void DMARingRelease( void )
+{
+	m_ring[m_ring_next_read].state = DMA_DESC_FREE;
+	m_ring_next_read = (m_ring_next_read + 1 < m_ring_depth) ? m_ring_next_read + 1 : 0;
+	return;
+}
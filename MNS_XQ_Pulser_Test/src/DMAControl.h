@@ -0,0 +1,76 @@
+/*
+ * DMAControl.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ *
+ * Handles starting AXI DMA transfers from the FPGA into DRAM and tracking their completion.
+ * The S2MM interrupt handler in main.c reports the completion of a transfer to this module,
+ *  so that the acquisition loops can wait on a real completion signal instead of sleeping.
+ */
+
+#ifndef SRC_DMACONTROL_H_
+#define SRC_DMACONTROL_H_
+
+#include <stdbool.h>
+#include <xil_io.h>
+#include "xil_cache.h"
+#include "xil_exception.h"
+#include "xil_printf.h"
+#include "xparameters.h"
+#include "xtime_l.h"
+#include "lunah_defines.h"
+#include "DataAcquisition.h"
+#include "DAQStatistics.h"
+
+//AXI DMA S2MM register offsets (Direct Register Mode)
+#define DMA_S2MM_DMACR_OFFSET	0x30	//control register
+#define DMA_S2MM_DMASR_OFFSET	0x34	//status register
+#define DMA_S2MM_DA_OFFSET		0x48	//destination address
+#define DMA_S2MM_LENGTH_OFFSET	0x58	//bytes to transfer, writing this starts the transfer
+//AXI DMA S2MM control register bits
+#define DMA_S2MM_RUN			0x0001	//run/stop
+#define DMA_S2MM_RESET			0x0004	//soft reset, reads back 1 until the reset is done
+#define DMA_S2MM_IOC_IRQ_EN		0x1000	//interrupt on complete enable
+//AXI DMA S2MM status register bits
+#define DMA_S2MM_HALTED			0x0001	//the channel is halted
+#define DMA_S2MM_IOC_IRQ		0x1000	//interrupt on complete, write-to-clear
+#define DMA_S2MM_ERR_IRQ		0x4000	//interrupt on error, write-to-clear
+
+#define DMA_TRANSFER_SIZE		65536	//the maximum number of bytes the DMA may move per transfer
+#define DMA_BUFFER_BYTES		(DATA_BUFFER_SIZE * 4)	//the bytes of each transfer we actually read (DRAM_BASE -> DRAM_CEILING)
+#define DMA_TRANSFER_TIMEOUT_US	1000	//a transfer normally takes ~54us, give up after this long
+#define DMA_RESET_TIMEOUT_US	100		//a soft reset takes a few AXI clocks, give up on it after this long
+
+//DAQ receive ring descriptor states
+#define DMA_DESC_FREE			0	//landing zone may be handed to the DMA
+#define DMA_DESC_IN_FLIGHT		1	//the DMA is writing into the landing zone
+#define DMA_DESC_DONE			2	//the landing zone holds a full buffer for the CPU
+#define DMA_DESC_ERROR			3	//the transfer failed or timed out, the CPU should skip it
+
+/*
+ * One entry in the DAQ receive ring. There is one descriptor per landing zone.
+ * The interrupt handler moves descriptors from IN_FLIGHT to DONE (or ERROR) and arms the next FREE one,
+ *  the acquisition loop moves them from DONE back to FREE once the buffer has been processed.
+ */
+typedef struct {
+	unsigned int addr;		//DRAM address of the landing zone
+	volatile int state;		//DMA_DESC_#
+}DMA_RING_DESC_TYPE;
+
+// prototypes
+void DMASetTransferComplete( unsigned int status_reg );
+void DMAStartTransfer( unsigned int dest_addr );
+bool DMAIsTransferInFlight( void );
+bool DMAIsTransferComplete( void );
+bool DMAHasTransferTimedOut( void );
+int DMAFinishTransfer( void );
+int DMAWaitForTransfer( void );
+unsigned int DMAGetTimeoutCount( void );
+int DMARingInit( int ring_depth );
+void DMARingStop( void );
+void DMARingService( void );
+unsigned int * DMARingGetCompleted( void );
+void DMARingRelease( void );
+
+#endif /* SRC_DMACONTROL_H_ */
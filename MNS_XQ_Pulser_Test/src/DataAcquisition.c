@@ -20,15 +20,178 @@ static unsigned int daq_run_id_number;
 static unsigned int daq_run_run_number;
 static unsigned int daq_run_set_number;
 
-static FIL m_EVT_file;
+static FIL m_EVT_files[2];			//the EVT set file being written and the next one, prepared ahead of the rollover
+static FIL * m_EVT_file = &m_EVT_files[0];	//the EVT set file being written
+static FIL * m_EVT_next_file;		//the next EVT set file, opened and headered, NULL until PrepareNextEVTFile()
+static FIL * m_EVT_retired_file;	//the previous EVT set file, waiting to be trimmed and closed
+static FIL m_EVT_header_files[2];	//a second handle on each EVT set file, for rewriting EVTDataEnd, see WriteEVTDataEnd()
+static char next_filename_EVT[100];
+static XTime m_cps_last_flush;		//when the CPS records were last written and synced
+
 static FIL m_CPS_file;
 static FIL m_2DH_file;
 
 
 
-static DATA_FILE_HEADER_TYPE file_header_to_write;	//320 bytes
+static int m_daq_options[DAQ_NUM_OPTIONS] = {DMA_DEFAULT_RING_DEPTH, RAW_MODE_OFF, RAW_DEFAULT_PARAM, EVT_DEFAULT_BATCH_BUFFERS, EVT_DEFAULT_SYNC_BLOCKS,
+												CPS_DEFAULT_FLUSH_RECORDS, CPS_DEFAULT_FLUSH_SECONDS, PULSER_DEFAULT_RATE, EVT_FORMAT_STANDARD,
+												EVT_COMPRESS_OFF, EVT_FILTER_ALL, 0, TWODH_X_BINS - 1, 0, TWODH_Y_BINS - 1, DCACHE_OFF};	//DAQ run options, see SetDAQOption()
+static int m_evt_batch_buffers = EVT_DEFAULT_BATCH_BUFFERS;	//FPGA buffers per EVT block, latched when the run files are created
+static int m_evt_sync_blocks = EVT_DEFAULT_SYNC_BLOCKS;		//EVT blocks per f_sync, latched when the run files are created
+static int m_evt_format = EVT_FORMAT_STANDARD;				//EVT_FORMAT_#, latched when the run files are created
+static int m_evt_compress = EVT_COMPRESS_OFF;				//EVT_COMPRESS_#, latched when the run files are created
+static int m_evt_filter = EVT_FILTER_ALL;					//EVT_FILTER_#, latched when the run files are created
+static int m_run_dcache = DCACHE_OFF;						//DCACHE_#, the data cache mode of the current or most recent run
+
+static DATA_FILE_HEADER_TYPE file_header_to_write;	//352 bytes
 static DATA_FILE_SECONDARY_HEADER_TYPE file_secondary_header_to_write;	//16 bytes
-static DATA_FILE_FOOTER_TYPE file_footer_to_write;	//20 bytes
+static DATA_FILE_FOOTER_TYPE file_footer_to_write;	//144 bytes
+
+static EVT_BLOCK_TYPE m_evt_write_queue_storage[EVT_WRITE_QUEUE_DEPTH];	//finished EVT blocks waiting for the SD card
+static SPSC_RING_TYPE m_evt_write_queue;		//write-behind queue of EVT blocks, see DrainWriteQueue()
+static unsigned char m_evt_compact_buff[sizeof(EVT_BLOCK_TYPE)];	//an EVT block re-encoded in the compact format
+static unsigned char m_evt_compress_buff[sizeof(EVT_COMPRESS_HEADER_TYPE) + sizeof(EVT_BLOCK_TYPE)];	//an EVT block after compression
+static char m_write_blank_space_buff[EVT_DATA_BUFF_SIZE];	//padding used to move the data in a new file up to the cluster edge
+static int m_write_header;						//write a file header the first time we use a file
+static int m_buffers_written;					//keep track of how many EVT blocks are written, but not synced
+
+static FIL m_raw_data_file;
+static int m_raw_file_open;						//the raw data file is only opened when raw capture is on
+static unsigned int m_raw_queue_storage[RAW_QUEUE_DEPTH][DATA_BUFFER_SIZE];	//raw buffers waiting for the SD card
+static SPSC_RING_TYPE m_raw_queue;
+static unsigned int m_raw_buffers_seen;			//buffers handed to CaptureRawBuffer() this run, for decimation
+static int m_raw_batches_written;				//raw batches written, but not synced
+
+/*
+ * Set one of the DAQ run options. These are set with the MNS_DAQCFG command before a run is
+ *  started and are applied when DataAcquisition() begins. They keep their value until they are
+ *  changed again or the system power cycles.
+ *
+ * Options:
+ * 	DAQ_OPT_RING_DEPTH	= number of DMA landing zones in the receive ring, 2 -> DMA_MAX_RING_DEPTH
+ * 	DAQ_OPT_RAW_MODE	= raw buffer capture, RAW_MODE_OFF/FULL/FIRST_N/DECIMATED
+ * 	DAQ_OPT_RAW_PARAM	= seconds to capture for RAW_MODE_FIRST_N, or keep 1 of N buffers for RAW_MODE_DECIMATED
+ * 	DAQ_OPT_EVT_BATCH	= FPGA buffers collected into each EVT block, 1 -> EVT_MAX_BATCH_BUFFERS
+ * 	DAQ_OPT_EVT_SYNC	= EVT blocks written between each f_sync, 1 -> EVT_MAX_SYNC_BLOCKS
+ *
+ * 	DAQ_OPT_CPS_FLUSH_RECORDS	= write and sync the CPS file once this many records are waiting, 1 -> CPS_MAX_FLUSH_RECORDS
+ * 	DAQ_OPT_CPS_FLUSH_SECONDS	= write and sync the CPS file at least this often, 1 -> CPS_MAX_FLUSH_SECONDS
+ * 	DAQ_OPT_PULSER_RATE	= pulses per second the pulser injects, 0 -> PULSER_MAX_RATE, 0 if there is no pulser
+ * 	DAQ_OPT_EVT_FORMAT	= the EVT file format, EVT_FORMAT_STANDARD/COMPACT
+ * 	DAQ_OPT_EVT_COMPRESS	= compress each EVT block before it is written, EVT_COMPRESS_OFF/ON
+ * 	DAQ_OPT_EVT_FILTER	= which data events are stored in the EVT file, EVT_FILTER_ALL/NEUTRONS/REGION
+ * 	DAQ_OPT_FILTER_ENERGY_MIN/MAX	= energy bins kept by EVT_FILTER_REGION, 0 -> TWODH_X_BINS - 1
+ * 	DAQ_OPT_FILTER_PSD_MIN/MAX	= PSD bins kept by EVT_FILTER_REGION, 0 -> TWODH_Y_BINS - 1
+ * 	DAQ_OPT_DCACHE	= run with the L1/L2 data caches on, DCACHE_OFF/ON
+ *
+ * The EVT batching, format, compression, and filter options are recorded in the file headers, so they are latched when the MNS_DAQ
+ *  command creates the run files. Changing them after that applies to the next run.
+ *
+ * @param	(int) the option number, DAQ_OPT_#
+ * @param	(int) the value to set
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if the option or value is out of range
+ */
+int SetDAQOption( int option, int value )
+{
+	int status = CMD_FAILURE;
+
+	switch(option)
+	{
+	case DAQ_OPT_RING_DEPTH:
+		if(value >= 2 && value <= DMA_MAX_RING_DEPTH)
+			status = CMD_SUCCESS;
+		break;
+	case DAQ_OPT_RAW_MODE:
+		if(value >= RAW_MODE_OFF && value <= RAW_MODE_DECIMATED)
+			status = CMD_SUCCESS;
+		break;
+	case DAQ_OPT_RAW_PARAM:
+		if(value >= 1)
+			status = CMD_SUCCESS;
+		break;
+	case DAQ_OPT_EVT_BATCH:
+		if(value >= 1 && value <= EVT_MAX_BATCH_BUFFERS)
+			status = CMD_SUCCESS;
+		break;
+	case DAQ_OPT_EVT_SYNC:
+		if(value >= 1 && value <= EVT_MAX_SYNC_BLOCKS)
+			status = CMD_SUCCESS;
+		break;
+	case DAQ_OPT_CPS_FLUSH_RECORDS:
+		if(value >= 1 && value <= CPS_MAX_FLUSH_RECORDS)
+			status = CMD_SUCCESS;
+		break;
+	case DAQ_OPT_CPS_FLUSH_SECONDS:
+		if(value >= 1 && value <= CPS_MAX_FLUSH_SECONDS)
+			status = CMD_SUCCESS;
+		break;
+	case DAQ_OPT_PULSER_RATE:
+		if(value >= 0 && value <= PULSER_MAX_RATE)
+			status = CMD_SUCCESS;
+		break;
+	case DAQ_OPT_EVT_FORMAT:
+		if(value == EVT_FORMAT_STANDARD || value == EVT_FORMAT_COMPACT)
+			status = CMD_SUCCESS;
+		break;
+	case DAQ_OPT_EVT_COMPRESS:
+		if(value == EVT_COMPRESS_OFF || value == EVT_COMPRESS_ON)
+			status = CMD_SUCCESS;
+		break;
+	case DAQ_OPT_EVT_FILTER:
+		if(value == EVT_FILTER_ALL || value == EVT_FILTER_NEUTRONS || value == EVT_FILTER_REGION)
+			status = CMD_SUCCESS;
+		break;
+	case DAQ_OPT_FILTER_ENERGY_MIN:
+	case DAQ_OPT_FILTER_ENERGY_MAX:
+		if(value >= 0 && value < TWODH_X_BINS)
+			status = CMD_SUCCESS;
+		break;
+	case DAQ_OPT_FILTER_PSD_MIN:
+	case DAQ_OPT_FILTER_PSD_MAX:
+		if(value >= 0 && value < TWODH_Y_BINS)
+			status = CMD_SUCCESS;
+		break;
+	case DAQ_OPT_DCACHE:
+		if(value == DCACHE_OFF || value == DCACHE_ON)
+			status = CMD_SUCCESS;
+		break;
+	default:
+		break;
+	}
+
+	if(status == CMD_SUCCESS)
+		m_daq_options[option] = value;
+
+	return status;
+}
+
+/*
+ * Getter function for the data cache mode of the current or most recent run. This is reported
+ *  with the stage profile so the two modes can be compared.
+ *
+ * @param	None
+ *
+ * @return	(int) DCACHE_OFF/DCACHE_ON
+ */
+int GetRunDCacheMode( void )
+{
+	return m_run_dcache;
+}
+
+/*
+ * Getter function for the DAQ run options.
+ *
+ * @param	(int) the option number, DAQ_OPT_#
+ *
+ * @return	(int) the value of the option, 0 if the option does not exist
+ */
+int GetDAQOption( int option )
+{
+	if(option < 0 || option >= DAQ_NUM_OPTIONS)
+		return 0;
+	return m_daq_options[option];
+}
 
 /*
  * Getter function to get the folder name for the DAQ run which has been started.
@@ -308,6 +471,26 @@ int CreateDAQFiles( void )
 	file_header_to_write.TempCorrectionSetNum = 1;		//will have to get this from somewhere
 	file_header_to_write.EventID1 = 0xFF;
 	file_header_to_write.EventID2 = 0xFF;
+	//latch the EVT batching for this run and record it so the ground knows the EVT layout
+	m_evt_batch_buffers = GetDAQOption(DAQ_OPT_EVT_BATCH);
+	m_evt_sync_blocks = GetDAQOption(DAQ_OPT_EVT_SYNC);
+	file_header_to_write.EVTBatchBuffers = (unsigned int)m_evt_batch_buffers;
+	file_header_to_write.EVTSyncBlocks = (unsigned int)m_evt_sync_blocks;
+	m_evt_format = GetDAQOption(DAQ_OPT_EVT_FORMAT);
+	file_header_to_write.EVTFormat = (unsigned int)m_evt_format;
+	m_evt_compress = GetDAQOption(DAQ_OPT_EVT_COMPRESS);
+	file_header_to_write.EVTCompression = (unsigned int)m_evt_compress;
+	m_evt_filter = GetDAQOption(DAQ_OPT_EVT_FILTER);
+	file_header_to_write.EVTFilter = (unsigned int)m_evt_filter;
+	file_header_to_write.EVTFilterEnergyMin = (unsigned short)GetDAQOption(DAQ_OPT_FILTER_ENERGY_MIN);
+	file_header_to_write.EVTFilterEnergyMax = (unsigned short)GetDAQOption(DAQ_OPT_FILTER_ENERGY_MAX);
+	file_header_to_write.EVTFilterPSDMin = (unsigned short)GetDAQOption(DAQ_OPT_FILTER_PSD_MIN);
+	file_header_to_write.EVTFilterPSDMax = (unsigned short)GetDAQOption(DAQ_OPT_FILTER_PSD_MAX);
+	file_header_to_write.EVTDataEnd = 0;	//filled in for each EVT set file by WriteEVTDataEnd()
+	//the first EVT set file always goes in the first handle
+	m_EVT_file = &m_EVT_files[0];
+	m_EVT_next_file = NULL;
+	m_EVT_retired_file = NULL;
 
 	//open the run folder so we can create the files there
 	ffs_res = f_mkdir(current_run_folder);
@@ -336,7 +519,7 @@ int CreateDAQFiles( void )
 		case 0:
 			file_to_open = current_filename_EVT;
 			file_header_to_write.FileTypeAPID = DATA_TYPE_EVT;
-			DAQ_file = &m_EVT_file;
+			DAQ_file = m_EVT_file;
 			break;
 		case 1:
 			file_to_open = current_filename_CPS;
@@ -389,6 +572,12 @@ int CreateDAQFiles( void )
 						//record the new file information in the tx_bytes file
 //						sd_updateFileRecords(file_to_open, file_size(DAQ_file));
 					}
+					if(iter == 0)	//EVT files only, reserve the space for the whole set file
+					{
+						if(PreallocateEVTFile(DAQ_file) != CMD_SUCCESS)
+							xil_printf("15 error allocating DAQ\n");
+						OpenEVTHeaderFile(DAQ_file, file_to_open);
+					}
 					if(iter < 2)	//sync the EVT, CPS files; we're leaving them open during the run
 					{
 						ffs_res = f_sync(DAQ_file);
@@ -431,7 +620,7 @@ int CreateDAQFiles( void )
 
 FIL *GetEVTFilePointer( void )
 {
-	return &m_EVT_file;
+	return m_EVT_file;
 }
 
 FIL *GetCPSFilePointer( void )
@@ -476,6 +665,867 @@ int WriteRealTime( unsigned long long int real_time )
 	return status;
 }
 
+/*
+ * Write the CPS records which the processing stage has queued up into the CPS file.
+ * This is the I/O stage side of the CPS record queue; ProcessData() pushes a record each time
+ *  a one-second interval closes and never touches the SD card itself.
+ * The records are held in the queue (RAM) until the flush policy says to write them:
+ *  DAQ_OPT_CPS_FLUSH_RECORDS records are waiting, or DAQ_OPT_CPS_FLUSH_SECONDS seconds have
+ *  passed since the last flush, whichever comes first. All of the waiting records then go out
+ *  with as few writes as possible and a single f_sync. END, BREAK, and the run time out always
+ *  force a flush, and so does ProcessData() if the queue fills up inside one buffer.
+ * On a power failure the CPS file loses at most the records which were waiting, which is the
+ *  lesser of the two limits plus the interval which was still being counted.
+ *
+ * @param	(int) 0 to follow the flush policy, 1 to write and sync everything now
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if a write or the sync failed
+ */
+int WriteCPSRecords( int force )
+{
+	int status = CMD_SUCCESS;
+	unsigned int num_records = 0;
+	unsigned int iter = 0;
+	unsigned int bytes_written = 0;
+	XTime m_current_time;
+	FRESULT f_res = FR_OK;
+	SPSC_RING_TYPE * cps_queue = GetCPSRecordQueue();
+	CPS_EVENT_STRUCT_TYPE * cps_record = NULL;
+
+	num_records = SPSCRingCount(cps_queue);
+	if(num_records == 0)
+		return CMD_SUCCESS;
+	XTime_GetTime(&m_current_time);
+	if(force == 0
+			&& num_records < (unsigned int)GetDAQOption(DAQ_OPT_CPS_FLUSH_RECORDS)
+			&& (m_current_time - m_cps_last_flush) < (XTime)GetDAQOption(DAQ_OPT_CPS_FLUSH_SECONDS) * COUNTS_PER_SECOND)
+		return CMD_SUCCESS;
+
+	//records which sit next to each other in the queue go out in one write, at most two writes when the queue wraps
+	while((cps_record = (CPS_EVENT_STRUCT_TYPE *)SPSCRingPeek(cps_queue)) != NULL)
+	{
+		num_records = SPSCRingCountContiguous(cps_queue);
+		f_res = f_write(&m_CPS_file, cps_record, num_records * sizeof(CPS_EVENT_STRUCT_TYPE), &bytes_written);
+		if(f_res != FR_OK || bytes_written != num_records * sizeof(CPS_EVENT_STRUCT_TYPE))
+		{
+			//TODO:handle error with writing
+			xil_printf("error writing 4\n");
+			status = CMD_FAILURE;
+		}
+		for(iter = 0; iter < num_records; iter++)
+			SPSCRingPop(cps_queue);
+	}
+
+	f_res = f_sync(&m_CPS_file);
+	if(f_res != FR_OK)
+	{
+		//TODO:handle error with writing
+		xil_printf("error writing 5\n");
+		status = CMD_FAILURE;
+	}
+	m_cps_last_flush = m_current_time;
+
+	return status;
+}
+
+/*
+ * Open the raw data file in the run folder if raw capture was turned on for this run.
+ * The raw data file holds the unprocessed buffers from the FPGA and is only for debugging, so
+ *  normal science runs (RAW_MODE_OFF) never create it.
+ *
+ * @param	None
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if the file could not be opened
+ */
+int OpenRawDataFile( void )
+{
+	char raw_filename[100] = "";
+	FRESULT f_res = FR_OK;
+
+	m_raw_file_open = 0;
+	m_raw_buffers_seen = 0;
+	m_raw_batches_written = 0;
+	SPSCRingInit(&m_raw_queue, m_raw_queue_storage, DATA_BUFFER_SIZE * 4, RAW_QUEUE_DEPTH);
+
+	if(GetDAQOption(DAQ_OPT_RAW_MODE) == RAW_MODE_OFF)
+		return CMD_SUCCESS;
+
+	snprintf(raw_filename, 100, "%s/raw_data.bin", current_run_folder);
+	f_res = f_open(&m_raw_data_file, raw_filename, FA_OPEN_ALWAYS|FA_READ|FA_WRITE);
+	if(f_res != FR_OK)
+		return CMD_FAILURE;
+	sd_totalFilesIncrement();
+	m_raw_file_open = 1;
+
+	return CMD_SUCCESS;
+}
+
+/*
+ * Decide whether a raw buffer is kept under the current raw capture mode and queue it for the SD card.
+ * This must be called before the landing zone is handed back to the DMA.
+ *
+ * @param	(unsigned int *) pointer to the buffer from the DMA, DATA_BUFFER_SIZE ints long
+ * @param	(int) the number of seconds since the run started
+ *
+ * @return	None
+ */
+void CaptureRawBuffer( unsigned int * data_raw, int run_seconds )
+{
+	int capture = 0;
+
+	if(m_raw_file_open == 0)
+		return;
+
+	switch(GetDAQOption(DAQ_OPT_RAW_MODE))
+	{
+	case RAW_MODE_FULL:
+		capture = 1;
+		break;
+	case RAW_MODE_FIRST_N:
+		if(run_seconds < GetDAQOption(DAQ_OPT_RAW_PARAM))
+			capture = 1;
+		break;
+	case RAW_MODE_DECIMATED:
+		if(m_raw_buffers_seen % (unsigned int)GetDAQOption(DAQ_OPT_RAW_PARAM) == 0)
+			capture = 1;
+		break;
+	default:
+		break;
+	}
+	m_raw_buffers_seen++;
+
+	if(capture == 1)
+	{
+		//if the queue is full the buffer is lost, the queue counts the overflow for the footer
+		(void)SPSCRingPush(&m_raw_queue, data_raw);
+	}
+
+	return;
+}
+
+/*
+ * Write the queued raw buffers to the raw data file. Buffers are written RAW_BATCH_BUFFERS at a
+ *  time with a single f_write and the file is synced every RAW_SYNC_BATCHES batches.
+ *
+ * @param	(int) 0 to write one batch only if a full batch is waiting,
+ * 				  1 to write everything waiting and sync the file (end of run)
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if a write or sync failed
+ */
+int WriteRawBatches( int flush )
+{
+	int status = CMD_SUCCESS;
+	unsigned int num_buffers = 0;
+	unsigned int iter = 0;
+	unsigned int bytes_written = 0;
+	FRESULT f_res = FR_OK;
+	unsigned int * raw_batch = NULL;
+
+	if(m_raw_file_open == 0)
+		return CMD_SUCCESS;
+	if(flush == 0 && SPSCRingCount(&m_raw_queue) < RAW_BATCH_BUFFERS)
+		return CMD_SUCCESS;
+
+	do
+	{
+		//only buffers which are next to each other in the queue storage can go out in one write
+		num_buffers = SPSCRingCountContiguous(&m_raw_queue);
+		if(num_buffers > RAW_BATCH_BUFFERS)
+			num_buffers = RAW_BATCH_BUFFERS;
+		raw_batch = (unsigned int *)SPSCRingPeek(&m_raw_queue);
+		if(raw_batch == NULL || num_buffers == 0)
+			break;
+
+		f_res = f_write(&m_raw_data_file, raw_batch, num_buffers * DATA_BUFFER_SIZE * 4, &bytes_written);
+		if(f_res != FR_OK || bytes_written != num_buffers * DATA_BUFFER_SIZE * 4)
+			status = CMD_FAILURE;
+		for(iter = 0; iter < num_buffers; iter++)
+			SPSCRingPop(&m_raw_queue);
+
+		m_raw_batches_written++;
+		if(m_raw_batches_written >= RAW_SYNC_BATCHES || flush == 1)
+		{
+			f_res = f_sync(&m_raw_data_file);
+			if(f_res != FR_OK)
+			{
+				//TODO: error check
+				xil_printf("8 error syncing DAQ\n");
+				status = CMD_FAILURE;
+			}
+			m_raw_batches_written = 0;
+		}
+	}while(flush == 1);
+
+	return status;
+}
+
+/*
+ * Write out anything still queued and close the raw data file, if it was opened for this run.
+ *
+ * @param	None
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if the last writes failed
+ */
+int CloseRawDataFile( void )
+{
+	int status = CMD_SUCCESS;
+
+	if(m_raw_file_open == 0)
+		return CMD_SUCCESS;
+
+	status = WriteRawBatches(1);
+	f_close(&m_raw_data_file);
+	m_raw_file_open = 0;
+
+	return status;
+}
+
+/*
+ * Get the header handle which goes with an EVT set file handle.
+ *
+ * @param	(FIL *) the EVT set file, one of m_EVT_files
+ *
+ * @return	(FIL *) the header handle, NULL if it is not open
+ */
+static FIL * GetEVTHeaderFile( FIL * evt_file )
+{
+	FIL * header_file = &m_EVT_header_files[evt_file == &m_EVT_files[0] ? 0 : 1];
+
+	if(header_file->fs == NULL)
+		return NULL;
+	return header_file;
+}
+
+/*
+ * Open the second handle on an EVT set file which WriteEVTDataEnd() uses to rewrite the header.
+ * Call this once the file has its headers and has been preallocated and synced, so that this
+ *  handle starts from the same directory entry as the data handle.
+ * If this fails, WriteEVTDataEnd() seeks the data handle instead, which is slower but still works.
+ *
+ * @param	(FIL *) the EVT set file, one of m_EVT_files
+ * @param	(char *) the name of the EVT set file
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if the file could not be opened a second time
+ */
+int OpenEVTHeaderFile( FIL * evt_file, char * filename )
+{
+	FIL * header_file = &m_EVT_header_files[evt_file == &m_EVT_files[0] ? 0 : 1];
+
+	if(f_open(header_file, filename, FA_OPEN_EXISTING|FA_WRITE) != FR_OK)
+		return CMD_FAILURE;		//f_open leaves header_file->fs NULL
+
+	return CMD_SUCCESS;
+}
+
+/*
+ * Close the header handle of an EVT set file, if it is open. This has to happen before the data
+ *  handle is truncated or closed, so that the data handle writes the directory entry last.
+ *
+ * @param	(FIL *) the EVT set file, one of m_EVT_files
+ *
+ * @return	None
+ */
+static void CloseEVTHeaderFile( FIL * evt_file )
+{
+	FIL * header_file = GetEVTHeaderFile(evt_file);
+
+	if(header_file != NULL)
+		f_close(header_file);
+	return;
+}
+
+/*
+ * Record the end of the data in the EVTDataEnd field of an EVT set file's header. Call this before
+ *  each f_sync of the file so that the synced header always says where the synced data ends.
+ * The file pointer is left at the end of the data.
+ *
+ * The field is written through the file's header handle (see OpenEVTHeaderFile()), whose pointer
+ *  never leaves the first sector. Seeking the data handle back to the header would cost a walk of
+ *  the cluster chain on the way back to the end of the data: FatFs follows the FAT one cluster at a
+ *  time on a forward f_lseek, up to SIZE_10_MIB into the file. With the header handle the update is
+ *  the header sector and the directory entry, and the sector stays in the handle's buffer between
+ *  updates so it is never read again.
+ * The header handle's f_sync writes the file size it was opened with into the directory entry. The
+ *  data handle is always synced or closed right after this, which puts its own size back.
+ * Before the header handle is open (the first sync in PreallocateEVTFile(), the data end is still
+ *  in the first cluster) the data handle is seeked instead.
+ *
+ * @param	(FIL *) the EVT set file, open for writing
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if the header could not be updated
+ */
+int WriteEVTDataEnd( FIL * evt_file )
+{
+	int status = CMD_SUCCESS;
+	unsigned int data_end = (unsigned int)f_tell(evt_file);
+	unsigned int bytes_written = 0;
+	FIL * header_file = GetEVTHeaderFile(evt_file);
+	FRESULT f_res = FR_OK;
+
+	if(header_file != NULL)
+	{
+		f_res = f_lseek(header_file, offsetof(DATA_FILE_HEADER_TYPE, EVTDataEnd));
+		if(f_res == FR_OK)
+			f_res = f_write(header_file, &data_end, sizeof(data_end), &bytes_written);
+		if(f_res != FR_OK || bytes_written != sizeof(data_end))
+			status = CMD_FAILURE;
+		f_res = f_sync(header_file);
+		if(f_res != FR_OK)
+			status = CMD_FAILURE;
+		return status;
+	}
+
+	f_res = f_lseek(evt_file, offsetof(DATA_FILE_HEADER_TYPE, EVTDataEnd));
+	if(f_res == FR_OK)
+		f_res = f_write(evt_file, &data_end, sizeof(data_end), &bytes_written);
+	if(f_res != FR_OK || bytes_written != sizeof(data_end))
+		status = CMD_FAILURE;
+	f_res = f_lseek(evt_file, data_end);
+	if(f_res != FR_OK)
+		status = CMD_FAILURE;
+
+	return status;
+}
+
+/*
+ * Allocate the clusters for the whole EVT set file up front so that the writes during the run never
+ *  have to search for and chain new clusters. FatFs stretches a file opened for writing when we seek
+ *  past its end, and it takes the clusters following the last one allocated, so on a card with free
+ *  space the file is contiguous. The file pointer is put back at the end of the data, which is where
+ *  all of the writes and the rollover check work from; CloseEVTFile() trims the unused space.
+ * Syncing commits the stretched size to the directory entry, so until the file is closed its size
+ *  on the card is the preallocation, not the data. The end of the data is kept in the header
+ *  instead (EVTDataEnd, see DATA_FILE_HEADER_TYPE), which is how a file left open by a power loss
+ *  or reset is recovered.
+ *
+ * @param	(FIL *) the EVT set file, open for writing
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if the space could not be allocated (the file still grows as needed)
+ */
+int PreallocateEVTFile( FIL * evt_file )
+{
+	int status = CMD_SUCCESS;
+	DWORD data_end = f_tell(evt_file);
+	FRESULT f_res = FR_OK;
+
+	f_res = f_lseek(evt_file, EVT_PREALLOC_SIZE);
+	if(f_res != FR_OK || f_tell(evt_file) != EVT_PREALLOC_SIZE)
+		status = CMD_FAILURE;	//the card is full or close to it
+	f_res = f_lseek(evt_file, data_end);
+	if(f_res != FR_OK)
+		status = CMD_FAILURE;
+	//commit the cluster chain now rather than during the run, with the data end to go with it
+	if(WriteEVTDataEnd(evt_file) != CMD_SUCCESS)
+		status = CMD_FAILURE;
+	f_res = f_sync(evt_file);
+	if(f_res != FR_OK)
+		status = CMD_FAILURE;
+
+	return status;
+}
+
+/*
+ * Close an EVT set file, cutting off the preallocated space past the end of the data.
+ * The end of the data is the file pointer, all EVT writes are sequential.
+ *
+ * @param	(FIL *) the EVT set file
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if the file could not be truncated or closed
+ */
+int CloseEVTFile( FIL * evt_file )
+{
+	int status = CMD_SUCCESS;
+	FRESULT f_res = FR_OK;
+
+	if(evt_file == NULL || evt_file->fs == NULL)
+		return CMD_SUCCESS;	//not open
+
+	if(WriteEVTDataEnd(evt_file) != CMD_SUCCESS)
+		status = CMD_FAILURE;
+	CloseEVTHeaderFile(evt_file);
+	f_res = f_truncate(evt_file);
+	if(f_res != FR_OK)
+		status = CMD_FAILURE;
+	f_res = f_close(evt_file);
+	if(f_res != FR_OK)
+		status = CMD_FAILURE;
+
+	return status;
+}
+
+/*
+ * Open the next EVT set file ahead of the rollover and write its headers, padding, and
+ *  preallocation, so that the rollover itself is only a footer and a handle swap.
+ * The drain stage calls this in its spare time once the current file is getting close to
+ *  SIZE_10_MIB. The secondary header has to be filled in first (the first EVT block of the run).
+ * The file is only kept as the next file if its headers were written. Otherwise it is deleted and
+ *  m_EVT_next_file stays NULL, so RolloverEVTFile() tries again inline.
+ *
+ * @param	None
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if the next file could not be created
+ */
+int PrepareNextEVTFile( void )
+{
+	int status = CMD_SUCCESS;
+	int bytes_written = 0;
+	unsigned int num_bytes_written = 0;
+	FIL * next_file = NULL;
+	FRESULT f_res = FR_OK;
+
+	if(m_EVT_next_file != NULL)
+		return CMD_SUCCESS;		//already waiting
+
+	//the next file goes in whichever handle the current file isn't using
+	if(m_EVT_file == &m_EVT_files[0])
+		next_file = &m_EVT_files[1];
+	else
+		next_file = &m_EVT_files[0];
+	if(next_file == m_EVT_retired_file)
+	{
+		CloseEVTFile(m_EVT_retired_file);
+		m_EVT_retired_file = NULL;
+	}
+
+	bytes_written = snprintf(next_filename_EVT, 100, "evt_S%04d.bin", daq_run_set_number + 1);
+	if(bytes_written == 0)
+		return CMD_FAILURE;
+	f_res = f_open(next_file, next_filename_EVT, FA_OPEN_ALWAYS|FA_READ|FA_WRITE);
+	if(f_res != FR_OK)
+		return CMD_FAILURE;
+
+	file_header_to_write.SetNum = daq_run_set_number + 1;
+	file_header_to_write.FileTypeAPID = DATA_TYPE_EVT;	//change back to EVTS
+	f_res = f_lseek(next_file, 0);
+	if(f_res != FR_OK)
+		status = CMD_FAILURE;
+	//write file header
+	f_res = f_write(next_file, &file_header_to_write, sizeof(file_header_to_write), &num_bytes_written);
+	if(f_res != FR_OK || num_bytes_written != sizeof(file_header_to_write))
+		status = CMD_FAILURE;
+	//write secondary header
+	f_res = f_write(next_file, &file_secondary_header_to_write, sizeof(file_secondary_header_to_write), &num_bytes_written);
+	if(f_res != FR_OK || num_bytes_written != sizeof(file_secondary_header_to_write))
+		status = CMD_FAILURE;
+	//write blank bytes up to Cluster edge (16384)
+	f_res = f_write(next_file, m_write_blank_space_buff, 16384 - f_tell(next_file), &num_bytes_written);
+	if(f_res != FR_OK)
+		status = CMD_FAILURE;
+	if(status != CMD_SUCCESS)
+	{
+		//a file with a bad header must not become the next set file, throw it away and
+		// let the rollover try again
+		f_close(next_file);
+		f_unlink(next_filename_EVT);
+		return status;
+	}
+	if(PreallocateEVTFile(next_file) != CMD_SUCCESS)
+		xil_printf("15 error allocating DAQ\n");	//the file is still good, it just grows as it is written
+	OpenEVTHeaderFile(next_file, next_filename_EVT);
+
+	m_EVT_next_file = next_file;
+
+	return status;
+}
+
+/*
+ * Finish the current EVT set file and switch to the next one.
+ * The footer goes into the current file, then the prepared next file becomes the current one.
+ * The old file is left for the drain stage to trim and close in its spare time. If the next
+ *  file was not prepared yet, it is prepared here.
+ *
+ * @param	None
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE
+ */
+int RolloverEVTFile( void )
+{
+	int status = CMD_SUCCESS;
+	unsigned int bytes_written = 0;
+	FRESULT f_res = FR_OK;
+
+	if(m_EVT_next_file == NULL)
+	{
+		if(PrepareNextEVTFile() != CMD_SUCCESS)
+			return CMD_FAILURE;		//keep writing to the current file
+	}
+
+	//prepare and write in footer for file here
+	file_footer_to_write.digiTemp = GetDigiTemp();
+	UpdateFooterStatistics();
+	f_res = f_write(m_EVT_file, &file_footer_to_write, sizeof(file_footer_to_write), &bytes_written);
+	if(f_res != FR_OK || bytes_written != sizeof(file_footer_to_write))
+		status = CMD_FAILURE;
+
+	//one file may be waiting to close at a time
+	if(m_EVT_retired_file != NULL)
+		CloseEVTFile(m_EVT_retired_file);
+	m_EVT_retired_file = m_EVT_file;
+	m_EVT_file = m_EVT_next_file;
+	m_EVT_next_file = NULL;
+
+	daq_run_set_number++;
+	strcpy(current_filename_EVT, next_filename_EVT);
+	m_buffers_written = 0;
+	//record that we have created a new file
+	sd_totalFilesIncrement();
+	//record the new file information in the tx_bytes file
+//	sd_updateFileRecords(current_filename_EVT, file_size(m_EVT_file));
+
+	return status;
+}
+
+/*
+ * Close all of the EVT set files at the end of a run. The current and the retired files are
+ *  trimmed and closed, a next file which was prepared but never used is deleted.
+ *
+ * @param	None
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE
+ */
+int CloseEVTFiles( void )
+{
+	int status = CMD_SUCCESS;
+
+	if(CloseEVTFile(m_EVT_retired_file) != CMD_SUCCESS)
+		status = CMD_FAILURE;
+	m_EVT_retired_file = NULL;
+	if(CloseEVTFile(m_EVT_file) != CMD_SUCCESS)
+		status = CMD_FAILURE;
+	if(m_EVT_next_file != NULL && m_EVT_next_file->fs != NULL)
+	{
+		CloseEVTHeaderFile(m_EVT_next_file);
+		f_close(m_EVT_next_file);
+		f_unlink(next_filename_EVT);
+	}
+	m_EVT_next_file = NULL;
+
+	return status;
+}
+
+/*
+ * Copy the run accounting from the DAQ statistics and the event quality block into the footer. Call this right before the
+ *  footer is written so the EVT and CPS files carry the numbers up to that point in the run.
+ *
+ * @param	None
+ *
+ * @return	None
+ */
+void UpdateFooterStatistics( void )
+{
+	file_footer_to_write.BuffersProcessed = DAQStatsGetBuffersProcessed();
+	file_footer_to_write.BuffersDropped = DAQStatsGetBuffersDropped();
+	file_footer_to_write.BuffersOverrun = DAQStatsGetBuffersOverrun();
+	file_footer_to_write.DMATimeouts = DMAGetTimeoutCount();
+	file_footer_to_write.MaxLatencyUs = DAQStatsGetMaxLatencyUs();
+	file_footer_to_write.DeadTimeMs = DAQStatsGetDeadTimeMs();
+	file_footer_to_write.ProcessTimeMs = DAQStatsGetStageTimeMs(DAQ_STAGE_PROCESS);
+	file_footer_to_write.DrainTimeMs = DAQStatsGetStageTimeMs(DAQ_STAGE_DRAIN);
+	file_footer_to_write.SOHTimeMs = DAQStatsGetStageTimeMs(DAQ_STAGE_SOH);
+	file_footer_to_write.LoopMeanUs = DAQStatsGetStageMeanUs(DAQ_STAGE_LOOP);
+	file_footer_to_write.LoopMaxUs = DAQStatsGetStageMaxUs(DAQ_STAGE_LOOP);
+	file_footer_to_write.ProcessMaxUs = DAQStatsGetStageMaxUs(DAQ_STAGE_PROCESS);
+	file_footer_to_write.DrainMaxUs = DAQStatsGetStageMaxUs(DAQ_STAGE_DRAIN);
+	file_footer_to_write.RejectedTime = GetEventQuality()->rejected_time;
+	file_footer_to_write.RejectedEventNumber = GetEventQuality()->rejected_event_number;
+	file_footer_to_write.RejectedOrdering = GetEventQuality()->rejected_ordering;
+	file_footer_to_write.BadPSD = GetEventQuality()->bad_psd;
+	file_footer_to_write.MultiHit = GetEventQuality()->multi_hit;
+	file_footer_to_write.EnergyOutOfRange = GetEventQuality()->energy_out_of_range;
+	file_footer_to_write.JunkWords = GetEventQuality()->junk_words;
+	file_footer_to_write.BuffersResynced = DAQStatsGetBuffersResynced();
+	file_footer_to_write.MaxWordsSkipped = DAQStatsGetMaxWordsSkipped();
+	file_footer_to_write.PulserEvents = GetEventQuality()->pulser_events;
+	file_footer_to_write.FalseEvents = GetEventQuality()->false_events;
+	file_footer_to_write.FilteredEvents = GetEventQuality()->filtered_events;
+	file_footer_to_write.EVTQueueHighWater = GetEVTQueueHighWater();
+	file_footer_to_write.EVTQueueOverflows = GetEVTQueueOverflows();
+	file_footer_to_write.CPSQueueHighWater = GetCPSQueueHighWater();
+	file_footer_to_write.CPSQueueOverflows = GetCPSQueueOverflows();
+	file_footer_to_write.RawQueueHighWater = GetRawQueueHighWater();
+	file_footer_to_write.RawQueueOverflows = GetRawQueueOverflows();
+	return;
+}
+
+/*
+ * The drain stage of the write-behind queue.
+ * The acquisition loop drops each finished EVT block into the queue and ProcessData() drops each
+ *  finished CPS record into the CPS record queue; neither waits on the SD card. This function does
+ *  the FatFs work for them: it writes the first-use file headers, rolls the EVT file over when it
+ *  grows past SIZE_10_MIB, writes the queued EVT blocks, and syncs the EVT file every 4th block.
+ * It is called between DMA transfers, so the number of EVT blocks written per call is limited to
+ *  keep the time away from the DMA ring short.
+ *
+ * @param	(int) the most EVT blocks to write in this call
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if any of the writes failed
+ */
+int DrainWriteQueue( int max_blocks )
+{
+	int status = CMD_SUCCESS;
+	int blocks_written = 0;
+	unsigned int bytes_written = 0;
+	unsigned int block_bytes = 0;
+	unsigned int compact_bytes = 0;
+	unsigned int compress_bytes = 0;
+	unsigned char * block_data = NULL;
+	FRESULT f_res = FR_OK;
+	EVT_BLOCK_TYPE * evt_block = NULL;
+	XTime compress_start = 0;
+	XTime compress_end = 0;
+
+	//the CPS records are written when the flush policy says so
+	status = WriteCPSRecords(0);
+
+	while(blocks_written < max_blocks)
+	{
+		evt_block = (EVT_BLOCK_TYPE *)SPSCRingPeek(&m_evt_write_queue);
+		if(evt_block == NULL)
+			break;
+
+		//check the size of the data in the file and see if we need to change files //the file itself is preallocated past this
+		if(f_tell(m_EVT_file) >= SIZE_10_MIB)
+		{
+			if(RolloverEVTFile() != CMD_SUCCESS)
+				status = CMD_FAILURE;
+		}
+
+		if(m_write_header == 1)
+		{
+			//get the first event and the real time
+			file_secondary_header_to_write.RealTime = GetRealTimeParam();
+			file_secondary_header_to_write.EventID1 = 0xFF;
+			file_secondary_header_to_write.EventID2 = 0xEE;
+			file_secondary_header_to_write.EventID3 = 0xDD;
+			file_secondary_header_to_write.EventID4 = 0xCC;
+			file_secondary_header_to_write.FirstEventTime = GetFirstEventTime();
+			file_secondary_header_to_write.EventID5 = 0xCC;
+			file_secondary_header_to_write.EventID6 = 0xDD;
+			file_secondary_header_to_write.EventID7 = 0xEE;
+			file_secondary_header_to_write.EventID8 = 0xFF;
+
+			f_res = f_write(m_EVT_file, &file_secondary_header_to_write, sizeof(file_secondary_header_to_write), &bytes_written);
+			if(f_res != FR_OK || bytes_written != sizeof(file_secondary_header_to_write))
+			{
+				//TODO: handle error checking the write
+				xil_printf("10 error writing DAQ\n");
+			}
+			//write blank bytes up to Cluster edge (16384)
+			f_res = f_write(m_EVT_file, m_write_blank_space_buff, 16384 - f_tell(m_EVT_file), &bytes_written);
+			if(f_res != FR_OK || bytes_written != sizeof(file_secondary_header_to_write))
+				status = CMD_FAILURE;
+
+//					sd_updateFileRecords(current_filename_EVT, file_size(m_EVT_file));
+
+			f_res = f_lseek(&m_CPS_file, sizeof(file_header_to_write));	//want to move to the reserved space we allocated before the run, directly after header
+			f_res = f_write(&m_CPS_file, &file_secondary_header_to_write, sizeof(file_secondary_header_to_write), &bytes_written);
+			if(f_res != FR_OK || bytes_written != sizeof(file_secondary_header_to_write))
+			{
+				//TODO: handle error checking the write
+				xil_printf("10 error writing DAQ\n");
+			}
+//					sd_updateFileRecords(current_filename_CPS, file_size(&m_CPS_file));
+
+			f_res = f_lseek(&m_CPS_file, file_size(&m_CPS_file));	//forward the file pointer so we're at the top of the file again
+
+			//also write the footer information that isn't going to change //this way we only do it once
+			file_footer_to_write.eventID1 = 0xFF;
+			file_footer_to_write.eventID2 = 0x45;
+			file_footer_to_write.eventID3 = 0x4E;
+			file_footer_to_write.eventID4 = 0x44;
+			file_footer_to_write.RealTime = GetRealTimeParam();
+			file_footer_to_write.eventID5 = 0xFF;
+			file_footer_to_write.eventID6 = 0x45;
+			file_footer_to_write.eventID7 = 0x4E;
+			file_footer_to_write.eventID8 = 0x44;
+			file_footer_to_write.eventID9 = 0xFF;
+			file_footer_to_write.eventID10 = 0x45;
+			file_footer_to_write.eventID11 = 0x4E;
+			file_footer_to_write.eventID12 = 0x44;
+			m_write_header = 0;	//turn off header writing //never come back here
+		}
+
+		//only the block header and the events which were filled are written
+		block_bytes = sizeof(EVT_BLOCK_HEADER_TYPE) + evt_block->header.num_events * sizeof(GENERAL_EVENT_TYPE);
+		block_data = (unsigned char *)evt_block;
+		compact_bytes = 0;
+		if(m_evt_format == EVT_FORMAT_COMPACT)
+			compact_bytes = EVTCompactEncodeBlock((unsigned char *)evt_block->events, evt_block->header.num_events, m_evt_compact_buff, block_bytes);
+		if(compact_bytes > 0)
+		{
+			block_data = m_evt_compact_buff;
+			block_bytes = compact_bytes;
+		}
+		//compress whichever block we have, standard blocks are coded one byte plane per event byte
+		//the time per block is profiled on its own, this is how the compressor is checked against the acquisition rate
+		if(m_evt_compress == EVT_COMPRESS_ON)
+		{
+			XTime_GetTime(&compress_start);
+			compress_bytes = EVTCompressBlock(block_data, block_bytes, compact_bytes > 0 ? 1 : sizeof(GENERAL_EVENT_TYPE), m_evt_compress_buff, sizeof(m_evt_compress_buff));
+			XTime_GetTime(&compress_end);
+			DAQStatsAddStageTime(DAQ_STAGE_COMPRESS, compress_end - compress_start);
+			if(compress_bytes > 0)
+			{
+				block_data = m_evt_compress_buff;
+				block_bytes = compress_bytes;
+			}
+		}
+		f_res = f_write(m_EVT_file, block_data, (UINT)block_bytes, &bytes_written);
+		if(f_res != FR_OK || bytes_written != block_bytes)
+		{
+			//TODO: handle error checking the write here
+			//now we need to check to make sure that there is a file open, if we get specific return values from f_write, need to check to see if we can open a file
+			xil_printf("7 error writing DAQ\n");
+		}
+		m_buffers_written++;
+		if(f_res == FR_OK && m_buffers_written >= m_evt_sync_blocks)
+		{
+			//the header has to say where the synced data ends, the file size covers the preallocation
+			if(WriteEVTDataEnd(m_EVT_file) != CMD_SUCCESS)
+				xil_printf("8 error syncing DAQ\n");
+			f_res = f_sync(m_EVT_file);
+			if(f_res != FR_OK)
+			{
+				//TODO: error check
+				xil_printf("8 error syncing DAQ\n");
+			}
+			m_buffers_written = 0;	//reset
+		}
+
+//				sd_updateFileRecords(current_filename_EVT, file_size(m_EVT_file));
+
+		//the block is on the card, give its slot back to the acquisition loop
+		SPSCRingPop(&m_evt_write_queue);
+		blocks_written++;
+	}
+
+	//spare time: get the EVT set files ready for the next rollover first, raw capture is for debugging
+	// and only gets the time nothing else needed
+	if(blocks_written < max_blocks)
+	{
+		if(m_EVT_retired_file != NULL)
+		{
+			if(CloseEVTFile(m_EVT_retired_file) != CMD_SUCCESS)
+				status = CMD_FAILURE;
+			m_EVT_retired_file = NULL;
+		}
+		else if(m_EVT_next_file == NULL && m_write_header == 0 && f_tell(m_EVT_file) >= SIZE_10_MIB - EVT_PREOPEN_MARGIN)
+		{
+			if(PrepareNextEVTFile() != CMD_SUCCESS)
+				status = CMD_FAILURE;
+		}
+		else if(WriteRawBatches(0) != CMD_SUCCESS)
+			status = CMD_FAILURE;
+	}
+
+	return status;
+}
+
+/*
+ * Empty the write-behind queue at the end of a run, including the EVT block which is still being
+ *  filled. The run can end part way through a batch (time out, BREAK, END), so the events which
+ *  have been processed since the last full block are queued as a short block and written too.
+ *
+ * @param	None
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if any of the writes failed
+ */
+int DrainAllEVTBlocks( void )
+{
+	int status = CMD_SUCCESS;
+
+	//make room first, the queue may be full
+	if(DrainWriteQueue(EVT_WRITE_QUEUE_DEPTH) != CMD_SUCCESS)
+		status = CMD_FAILURE;
+	if(GetEVTsBlockBytes() > (int)sizeof(EVT_BLOCK_HEADER_TYPE))
+	{
+		if(SPSCRingPushBytes(&m_evt_write_queue, GetEVTsBlock(), (unsigned int)GetEVTsBlockBytes()) != CMD_SUCCESS)
+		{
+			xil_printf("7 error queueing DAQ\n");
+			status = CMD_FAILURE;
+		}
+		ResetEVTsIterator();
+		if(DrainWriteQueue(EVT_WRITE_QUEUE_DEPTH) != CMD_SUCCESS)
+			status = CMD_FAILURE;
+	}
+
+	return status;
+}
+
+/*
+ * Getter function for the most EVT blocks which have been waiting in the write-behind queue at once.
+ * Use this with the overflow count to size EVT_WRITE_QUEUE_DEPTH.
+ *
+ * @param	None
+ *
+ * @return	(unsigned int) the high-water mark of the EVT write-behind queue for the current run
+ */
+unsigned int GetEVTQueueHighWater( void )
+{
+	return SPSCRingGetHighWater(&m_evt_write_queue);
+}
+
+/*
+ * Getter function for the number of EVT blocks which were dropped because the write-behind queue was full.
+ *
+ * @param	None
+ *
+ * @return	(unsigned int) the number of EVT blocks lost for the current run
+ */
+unsigned int GetEVTQueueOverflows( void )
+{
+	return SPSCRingGetOverflows(&m_evt_write_queue);
+}
+
+/*
+ * Getter function for the most CPS records which have been waiting to be written at once.
+ *
+ * @param	None
+ *
+ * @return	(unsigned int) the high-water mark of the CPS record queue for the current run
+ */
+unsigned int GetCPSQueueHighWater( void )
+{
+	return SPSCRingGetHighWater(GetCPSRecordQueue());
+}
+
+/*
+ * Getter function for the number of CPS records which were dropped because the record queue was full.
+ *
+ * @param	None
+ *
+ * @return	(unsigned int) the number of CPS records lost for the current run
+ */
+unsigned int GetCPSQueueOverflows( void )
+{
+	return SPSCRingGetOverflows(GetCPSRecordQueue());
+}
+
+/*
+ * Getter function for the most raw buffers which have been waiting for the SD card at once.
+ * Use this with the overflow count to size RAW_QUEUE_DEPTH.
+ *
+ * @param	None
+ *
+ * @return	(unsigned int) the high-water mark of the raw buffer queue for the current run
+ */
+unsigned int GetRawQueueHighWater( void )
+{
+	return SPSCRingGetHighWater(&m_raw_queue);
+}
+
+/*
+ * Getter function for the number of raw buffers which were not captured because the raw queue was full.
+ *
+ * @param	None
+ *
+ * @return	(unsigned int) the number of raw buffers lost for the current run
+ */
+unsigned int GetRawQueueOverflows( void )
+{
+	return SPSCRingGetOverflows(&m_raw_queue);
+}
+
 //Clears the BRAM buffers
 // I need to refresh myself as to why this is important
 // All that I remember is that it's important to do before each DRAM transfer
@@ -489,21 +1539,6 @@ void ClearBRAMBuffers( void )
 	Xil_Out32(XPAR_AXI_GPIO_9_BASEADDR,0);
 }
 
-void DAQReadDataIn( unsigned int *raw_array, int buffer_number )
-{
-	unsigned int dram_addr = DRAM_BASE;
-	int array_index = DATA_BUFFER_SIZE * buffer_number;
-
-	while(dram_addr < DRAM_CEILING)
-	{
-		raw_array[array_index] = Xil_In32(dram_addr);
-		dram_addr += 4;
-		array_index++;
-	}
-
-	return;
-}
-
 /* What it's all about.
  * The main event.
  * This is where we interact with the FPGA to receive data,
@@ -532,275 +1567,133 @@ int DataAcquisition( XIicPs * Iic, XUartPs Uart_PS, char * RecvBuffer, int time_
 	int status = CMD_SUCCESS;		//monitors the status of how we break out of DAQ
 	int status_SOH = CMD_SUCCESS;	//local status variable
 	int poll_val = 0;				//local polling status variable
-	int valid_data = 0;				//goes high/low if there is valid data within the FPGA buffers
+	int valid_data = 0;				//goes high when the DMA ring has a finished buffer for us
 	int buff_num = 0;				//keep track of which buffer we are writing
-	int buff_offset = 0;			//keep track of the buffer offset
-	int m_buffers_written = 0;		//keep track of how many buffers are written, but not synced
 //	int array_index = 0;			//the index of our array which will hold data
 //	int dram_addr = 0;				//the address in the DRAM we are reading from
 //	int dram_base = DRAM_BASE;		//where the buffer starts	//0x0A 00 00 00 = 167,772,160 //0x0A 00 40 00 = 167,788,544 - 167,788,544 = 16384
 	int m_run_time = time_out * 60;	//multiply minutes by 60 to get seconds
-	int m_write_header = 1;			//write a file header the first time we use a file
 	XTime m_run_start; 				//timing variable
 	XTime_GetTime(&m_run_start);	//record the "start" time to base a time out on
-	XTime m_run_current_time;		//timing variable
-	char m_write_blank_space_buff[16384] = "";
+	XTime m_run_current_time = m_run_start;		//timing variable
+	XTime m_loop_start = 0;			//timing variables for the DAQ statistics and stage profile
+	XTime m_stage_start = 0;
+	XTime m_stage_end = 0;
 	unsigned int bytes_written = 0;
 	FRESULT f_res = FR_OK;
-	GENERAL_EVENT_TYPE * evts_array = NULL;
-	//Data buffer which can hold 4096*4 integers, each buffer holds 512 8-integer events, x4 for four buffers
-	unsigned int data_array[DATA_BUFFER_SIZE * 4];
-	//if this doesn't work try allocating the array dynamically and try to see if the access time goes down
-//	buffers are 4096 ints long (512 events total)
-//	unsigned int *data_array;
-//	data_array = (unsigned int *)malloc(sizeof(unsigned int) * DATA_BUFFER_SIZE * 4);
-//	memset(data_array, '\0',  sizeof(unsigned int) * DATA_BUFFER_SIZE * 4);
-
+	//Points at the DMA landing zone holding the buffer to process, 4096 ints long (512 events total)
+	//ProcessData() walks the landing zone in place, there is no copy into a local array
+	unsigned int * data_raw = NULL;
 
 
-	//timing variables //delete when not timing
-//	XTime tBegin = 0;
-//	XTime tStart = 0;
-//	XTime tEnd = 0;
-
-	memset(&m_write_blank_space_buff, 186, 16384);
+	memset(m_write_blank_space_buff, 186, sizeof(m_write_blank_space_buff));
+	m_write_header = 1;
+	m_buffers_written = 0;
 
+	SetEVTsBatchSize(m_evt_batch_buffers);
+	SetEVTsFilter(m_evt_filter, file_header_to_write.EVTFilterEnergyMin, file_header_to_write.EVTFilterEnergyMax,
+					file_header_to_write.EVTFilterPSDMin, file_header_to_write.EVTFilterPSDMax);
 	ResetEVTsBuffer();
 	ResetEVTsIterator();
+	ResetCPSRecordQueue();
+	ResetEventQuality();
+	CPSSetPulserRate(GetDAQOption(DAQ_OPT_PULSER_RATE));
+	XTime_GetTime(&m_cps_last_flush);
+	DAQStatsReset();
+	SPSCRingInit(&m_evt_write_queue, m_evt_write_queue_storage, (unsigned int)GetEVTsMaxBlockBytes(), EVT_WRITE_QUEUE_DEPTH);
+	//the data caches are only on for runs which asked for them, main() turns them back off after the run
+	//the DMA landing zones are invalidated before they are read either way, see DMARingGetCompleted()
+	m_run_dcache = GetDAQOption(DAQ_OPT_DCACHE);
+	if(m_run_dcache == DCACHE_ON)
+		Xil_DCacheEnable();
+	//the DMA ring depth was set with MNS_DAQCFG before the run was started
+	if(DMARingInit(GetDAQOption(DAQ_OPT_RING_DEPTH)) != CMD_SUCCESS)
+		DMARingInit(DMA_DEFAULT_RING_DEPTH);
 
 	SetModeByte(MODE_DAQ);
 
-	//create file to save the raw integers to
-#ifdef PRODUCE_RAW_DATA
-	FIL m_raw_data_file;
-	f_res = f_open(&m_raw_data_file, "raw_data.bin", FA_OPEN_ALWAYS|FA_READ|FA_WRITE);
-#endif
+	//create the file to save the raw integers to, only if raw capture was requested with MNS_DAQCFG
+	if(OpenRawDataFile() != CMD_SUCCESS)
+		xil_printf("13 error opening raw DAQ\n");
 
 	while(done != 1)
 	{
-		valid_data = Xil_In32 (XPAR_AXI_GPIO_11_BASEADDR);
+		//the interrupt handler keeps the DMA moving buffers into the ring while we work,
+		// here we restart it if it went idle and collect the oldest finished buffer
+		XTime_GetTime(&m_loop_start);
+		DMARingService();
+		data_raw = DMARingGetCompleted();
+		XTime_GetTime(&m_stage_start);
+		if(data_raw != NULL)
+		{
+			valid_data = 1;
+			DAQStatsAddStageTime(DAQ_STAGE_DMA, m_stage_start - m_loop_start);	//only the passes which got a buffer
+		}
 		if(valid_data == 1)
 		{
-//**************//Start timing here for tracking the latency
-//			XTime_GetTime(&tBegin);
-//			XTime_GetTime(&tStart);
-
-			//init/start MUX to transfer data between integrator modules and the DMA
-			Xil_Out32 (XPAR_AXI_GPIO_15_BASEADDR, 1);
-			Xil_Out32 (XPAR_AXI_DMA_0_BASEADDR + 0x48, DRAM_BASE);
-			Xil_Out32 (XPAR_AXI_DMA_0_BASEADDR + 0x58, 65536);
-			usleep(54);
-			//TODO: need to check a shared variable within the interrupt handler and this function
-			// to see if the transfer is completed
-			//This check would replace the sleep statement.
-
-			Xil_Out32 (XPAR_AXI_GPIO_15_BASEADDR, 0);
-			ClearBRAMBuffers();
-			Xil_DCacheInvalidateRange(DRAM_BASE, 65536);
-
-//			XTime_GetTime(&tEnd);
-//			printf("DMA Transfer took %.2f us\n", 1.0 * (tEnd - tStart) / (COUNTS_PER_SECOND/1000000));
-//*************//Time just the read-in loop
-
-//			dram_addr = dram_base;
-//			array_index = DATA_BUFFER_SIZE * buff_num;
-//			while(dram_addr < DRAM_CEILING)
-//			{
-//				data_array[array_index] = Xil_In32(dram_addr);
-//				dram_addr += 4;
-//				array_index++;
-//			}
-
-//**************//here is where we just finished the DMA transfer between the FPGA and the processor
-//			XTime_GetTime(&tStart);
-			DAQReadDataIn( data_array, buff_num);
-
-//			XTime_GetTime(&tEnd);
-//			printf("Read-in loop took %.2f us\n", 1.0 * (tEnd - tStart) / (COUNTS_PER_SECOND/1000000));
-//*************//Time just the read-in loop
-
-
-//*************//Time just the process data loop
-//			XTime_GetTime(&tStart);
-
-			buff_offset = DATA_BUFFER_SIZE * buff_num;
-			status_SOH = ProcessData( &data_array[buff_offset] );
+			status_SOH = ProcessData( data_raw );
+			XTime_GetTime(&m_stage_end);
+			DAQStatsAddStageTime(DAQ_STAGE_PROCESS, m_stage_end - m_stage_start);
+			DAQStatsBufferProcessed();
 			buff_num++;
 
-//			XTime_GetTime(&tEnd);
-//			printf("ProcessData loop took %.2f us\n", 1.0 * (tEnd - tStart) / (COUNTS_PER_SECOND/1000000));
-//*************//End of timing just the process data loop
+			m_stage_start = m_stage_end;
+			//copy the raw buffer out before its landing zone is handed back to the DMA
+			CaptureRawBuffer(data_raw, (int)((m_run_current_time - m_run_start)/COUNTS_PER_SECOND));
+			//we are done reading this landing zone, hand it back to the DMA
+			DMARingRelease();
 
-			if(buff_num == 4)	//keep this to every 4th buffer, that's what it's set up for...
+			if(buff_num >= m_evt_batch_buffers)	//the EVT block is full once we have processed a batch of buffers
 			{
-
-//*************//Time the writing to SD card part of the loop
-//				XTime_GetTime(&tStart);
-
 				buff_num = 0;
 
-#ifdef PRODUCE_RAW_DATA
-				f_res = f_write(&m_raw_data_file, &data_array, DATA_BUFFER_SIZE * 4 * 4, &bytes_written);
-				if(f_res != FR_OK || bytes_written != DATA_BUFFER_SIZE * 4 * 4)
-					status = CMD_FAILURE;
-
-				f_res = f_sync(&m_raw_data_file);
-				if(f_res != FR_OK)
+				//hand the finished EVT block to the write-behind queue, the drain stage writes it to SD
+				//only the filled part of the block is copied, the events past it are stale and never written
+				if(SPSCRingPushBytes(&m_evt_write_queue, GetEVTsBlock(), (unsigned int)GetEVTsBlockBytes()) != CMD_SUCCESS)
 				{
-					//TODO: error check
-					xil_printf("8 error syncing DAQ\n");
+					//TODO: handle a full write-behind queue //the block is lost, the queue counts the overflow
+					xil_printf("7 error queueing DAQ\n");
 				}
-#endif
 
-				//check the file size and see if we need to change files
-				if(m_EVT_file.fsize >= SIZE_10_MIB)
-				{
-					//prepare and write in footer for file here
-					file_footer_to_write.digiTemp = GetDigiTemp();
-					f_res = f_write(&m_EVT_file, &file_footer_to_write, sizeof(file_footer_to_write), &bytes_written);
-					if(f_res != FR_OK || bytes_written != sizeof(file_footer_to_write))
-						status = CMD_FAILURE;
-
-					f_close(&m_EVT_file);
-					//create the new file name (increment the set number)
-					daq_run_set_number++; file_header_to_write.SetNum = daq_run_set_number;
-					file_header_to_write.FileTypeAPID = DATA_TYPE_EVT;	//change back to EVTS
-					bytes_written = snprintf(current_filename_EVT, 100, "evt_S%04d.bin", daq_run_set_number);
-					if(bytes_written == 0)
-						status = CMD_FAILURE;
-					f_res = f_open(&m_EVT_file, current_filename_EVT, FA_OPEN_ALWAYS|FA_READ|FA_WRITE);
-					if(f_res == FR_OK)
-					{
-						f_res = f_lseek(&m_EVT_file, 0);
-						if(f_res != FR_OK)
-							status = CMD_FAILURE;
-						//write file header
-						f_res = f_write(&m_EVT_file, &file_header_to_write, sizeof(file_header_to_write), &bytes_written);
-						if(f_res != FR_OK || bytes_written != sizeof(file_header_to_write))
-							status = CMD_FAILURE;
-						//write secondary header
-						f_res = f_write(&m_EVT_file, &file_secondary_header_to_write, sizeof(file_secondary_header_to_write), &bytes_written);
-						if(f_res != FR_OK || bytes_written != sizeof(file_secondary_header_to_write))
-							status = CMD_FAILURE;
-						//write blank bytes up to Cluster edge (16384
-						f_res = f_write(&m_EVT_file, m_write_blank_space_buff, 16384 - file_size(&m_EVT_file), &bytes_written);
-						if(f_res != FR_OK || bytes_written != sizeof(file_secondary_header_to_write))
-							status = CMD_FAILURE;
-						//record that we have created a new file
-						sd_totalFilesIncrement();
-						//record the new file information in the tx_bytes file
-//						sd_updateFileRecords(current_filename_EVT, file_size(&m_EVT_file));
-					}
-					else
-						status = CMD_FAILURE;
-					//update any more data structures?
-				}
-
-				if(m_write_header == 1)
-				{
-					//get the first event and the real time
-					file_secondary_header_to_write.RealTime = GetRealTimeParam();
-					file_secondary_header_to_write.EventID1 = 0xFF;
-					file_secondary_header_to_write.EventID2 = 0xEE;
-					file_secondary_header_to_write.EventID3 = 0xDD;
-					file_secondary_header_to_write.EventID4 = 0xCC;
-					file_secondary_header_to_write.FirstEventTime = GetFirstEventTime();
-					file_secondary_header_to_write.EventID5 = 0xCC;
-					file_secondary_header_to_write.EventID6 = 0xDD;
-					file_secondary_header_to_write.EventID7 = 0xEE;
-					file_secondary_header_to_write.EventID8 = 0xFF;
-
-					f_res = f_write(&m_EVT_file, &file_secondary_header_to_write, sizeof(file_secondary_header_to_write), &bytes_written);
-					if(f_res != FR_OK || bytes_written != sizeof(file_secondary_header_to_write))
-					{
-						//TODO: handle error checking the write
-						xil_printf("10 error writing DAQ\n");
-					}
-					//write blank bytes up to Cluster edge (16384)
-					f_res = f_write(&m_EVT_file, m_write_blank_space_buff, 16384 - file_size(&m_EVT_file), &bytes_written);
-					if(f_res != FR_OK || bytes_written != sizeof(file_secondary_header_to_write))
-						status = CMD_FAILURE;
-
-//					sd_updateFileRecords(current_filename_EVT, file_size(&m_EVT_file));
-
-					f_res = f_lseek(&m_CPS_file, sizeof(file_header_to_write));	//want to move to the reserved space we allocated before the run, directly after header
-					f_res = f_write(&m_CPS_file, &file_secondary_header_to_write, sizeof(file_secondary_header_to_write), &bytes_written);
-					if(f_res != FR_OK || bytes_written != sizeof(file_secondary_header_to_write))
-					{
-						//TODO: handle error checking the write
-						xil_printf("10 error writing DAQ\n");
-					}
-//					sd_updateFileRecords(current_filename_CPS, file_size(&m_CPS_file));
-
-					f_res = f_lseek(&m_CPS_file, file_size(&m_CPS_file));	//forward the file pointer so we're at the top of the file again
-
-					//also write the footer information that isn't going to change //this way we only do it once
-					file_footer_to_write.eventID1 = 0xFF;
-					file_footer_to_write.eventID2 = 0x45;
-					file_footer_to_write.eventID3 = 0x4E;
-					file_footer_to_write.eventID4 = 0x44;
-					file_footer_to_write.RealTime = GetRealTimeParam();
-					file_footer_to_write.eventID5 = 0xFF;
-					file_footer_to_write.eventID6 = 0x45;
-					file_footer_to_write.eventID7 = 0x4E;
-					file_footer_to_write.eventID8 = 0x44;
-					file_footer_to_write.eventID9 = 0xFF;
-					file_footer_to_write.eventID10 = 0x45;
-					file_footer_to_write.eventID11 = 0x4E;
-					file_footer_to_write.eventID12 = 0x44;
-					m_write_header = 0;	//turn off header writing //never come back here
-				}
-
-				evts_array = GetEVTsBufferAddress();
-				//TODO: check that the evts_array address is not NULL
-				f_res = f_write(&m_EVT_file, evts_array, EVT_DATA_BUFF_SIZE, &bytes_written); //write the entire events buffer
-				if(f_res != FR_OK || bytes_written != EVT_DATA_BUFF_SIZE)
-				{
-					//TODO: handle error checking the write here
-					//now we need to check to make sure that there is a file open, if we get specific return values from f_write, need to check to see if we can open a file
-					xil_printf("7 error writing DAQ\n");
-				}
-				m_buffers_written++;
-				if(f_res == FR_OK && m_buffers_written == 4)
-				{
-					f_res = f_sync(&m_EVT_file);
-					if(f_res != FR_OK)
-					{
-						//TODO: error check
-						xil_printf("8 error syncing DAQ\n");
-					}
-					m_buffers_written = 0;	//reset
-				}
-
-//				sd_updateFileRecords(current_filename_EVT, file_size(&m_EVT_file));
-
-				ResetEVTsBuffer();
 				ResetEVTsIterator();
-
-//****************//End timing of the loop here //we have finished processing and finished saving
-//				XTime_GetTime(&tEnd);
-//				printf("Write to SD loop took %.2f us\n", 1.0 * (tEnd - tStart) / (COUNTS_PER_SECOND/1000000));
 			}
-			valid_data = 0;	//reset
-
-//****************//End timing of the loop here //we have finished processing and finished saving
-//			XTime_GetTime(&tEnd);
-//			printf("Loop %d-%d took %.2f us\n", m_buffers_written, buff_num, 1.0 * (tEnd - tBegin) / (COUNTS_PER_SECOND/1000000));
+			XTime_GetTime(&m_stage_end);
+			DAQStatsAddStageTime(DAQ_STAGE_HANDOFF, m_stage_end - m_stage_start);
 		}//END OF IF VALID DATA
 
+		//run the drain stage while the DMA is filling the ring, or early if the queues are backing up
+		if(data_raw == NULL
+				|| SPSCRingCount(&m_evt_write_queue) >= EVT_WRITE_QUEUE_DEPTH / 2
+				|| SPSCRingCount(GetCPSRecordQueue()) >= CPS_RECORD_QUEUE_DEPTH / 2
+				|| SPSCRingCount(&m_raw_queue) >= RAW_BATCH_BUFFERS)
+		{
+			XTime_GetTime(&m_stage_start);
+			if(DrainWriteQueue(1) != CMD_SUCCESS)
+				status = CMD_FAILURE;
+			XTime_GetTime(&m_stage_end);
+			DAQStatsAddStageTime(DAQ_STAGE_DRAIN, m_stage_end - m_stage_start);
+		}
+
 		//check to see if it is time to report SOH information, 1 Hz
+		XTime_GetTime(&m_stage_start);
 		CheckForSOH(Iic, Uart_PS);	//disable SOH during DAQ so that it is easier to parse the timing output here //12-17-2019
 
 		//check for timeout
 		XTime_GetTime(&m_run_current_time);
 		if(((m_run_current_time - m_run_start)/COUNTS_PER_SECOND) >= m_run_time)
 		{
+			//everything queued and the partial EVT block have to be on the card before the footers go in,
+			// this always flushes the CPS records
+			if(DrainAllEVTBlocks() != CMD_SUCCESS)
+				status = CMD_FAILURE;
+			WriteCPSRecords(1);
 			file_footer_to_write.digiTemp = GetDigiTemp();
+			UpdateFooterStatistics();
 			//just keeping the Real Time from the space craft as the RealTime value
-			f_res = f_write(&m_EVT_file, &file_footer_to_write, sizeof(file_footer_to_write), &bytes_written);
+			f_res = f_write(m_EVT_file, &file_footer_to_write, sizeof(file_footer_to_write), &bytes_written);
 			if(f_res != FR_OK || bytes_written != sizeof(file_footer_to_write))
 				status = CMD_FAILURE;
-//			sd_updateFileRecords(current_filename_EVT, file_size(&m_EVT_file));
+//			sd_updateFileRecords(current_filename_EVT, file_size(m_EVT_file));
 			f_res = f_write(&m_CPS_file, &file_footer_to_write, sizeof(file_footer_to_write), &bytes_written);
 			if(f_res != FR_OK || bytes_written != sizeof(file_footer_to_write))
 				status = CMD_FAILURE;
@@ -810,6 +1703,11 @@ int DataAcquisition( XIicPs * Iic, XUartPs Uart_PS, char * RecvBuffer, int time_
 		}
 
 		poll_val = ReadCommandType(RecvBuffer, &Uart_PS);
+		XTime_GetTime(&m_stage_end);
+		DAQStatsAddStageTime(DAQ_STAGE_SOH, m_stage_end - m_stage_start);
+		if(valid_data == 1)
+			DAQStatsAddStageTime(DAQ_STAGE_LOOP, m_stage_end - m_loop_start);
+		valid_data = 0;	//reset
 		switch(poll_val)
 		{
 		case -1:
@@ -823,12 +1721,16 @@ int DataAcquisition( XIicPs * Iic, XUartPs Uart_PS, char * RecvBuffer, int time_
 				reportFailure(Uart_PS);
 			break;
 		case BREAK_CMD:
+			if(DrainAllEVTBlocks() != CMD_SUCCESS)
+				status = CMD_FAILURE;
+			WriteCPSRecords(1);
 			file_footer_to_write.digiTemp = GetDigiTemp();
+			UpdateFooterStatistics();
 			//have no END time to write here, so we use the START real time
-			f_res = f_write(&m_EVT_file, &file_footer_to_write, sizeof(file_footer_to_write), &bytes_written);
+			f_res = f_write(m_EVT_file, &file_footer_to_write, sizeof(file_footer_to_write), &bytes_written);
 			if(f_res != FR_OK || bytes_written != sizeof(file_footer_to_write))
 				status = CMD_FAILURE;
-//			sd_updateFileRecords(current_filename_EVT, file_size(&m_EVT_file));
+//			sd_updateFileRecords(current_filename_EVT, file_size(m_EVT_file));
 			f_res = f_write(&m_CPS_file, &file_footer_to_write, sizeof(file_footer_to_write), &bytes_written);
 			if(f_res != FR_OK || bytes_written != sizeof(file_footer_to_write))
 				status = CMD_FAILURE;
@@ -837,12 +1739,16 @@ int DataAcquisition( XIicPs * Iic, XUartPs Uart_PS, char * RecvBuffer, int time_
 			done = 1;
 			break;
 		case END_CMD:
+			if(DrainAllEVTBlocks() != CMD_SUCCESS)
+				status = CMD_FAILURE;
+			WriteCPSRecords(1);
 			file_footer_to_write.RealTime = GetRealTimeParam();
 			file_footer_to_write.digiTemp = GetDigiTemp();
-			f_res = f_write(&m_EVT_file, &file_footer_to_write, sizeof(file_footer_to_write), &bytes_written);
+			UpdateFooterStatistics();
+			f_res = f_write(m_EVT_file, &file_footer_to_write, sizeof(file_footer_to_write), &bytes_written);
 			if(f_res != FR_OK || bytes_written != sizeof(file_footer_to_write))
 				status = CMD_FAILURE;
-//			sd_updateFileRecords(current_filename_EVT, file_size(&m_EVT_file));
+//			sd_updateFileRecords(current_filename_EVT, file_size(m_EVT_file));
 			f_res = f_write(&m_CPS_file, &file_footer_to_write, sizeof(file_footer_to_write), &bytes_written);
 			if(f_res != FR_OK || bytes_written != sizeof(file_footer_to_write))
 				status = CMD_FAILURE;
@@ -855,6 +1761,9 @@ int DataAcquisition( XIicPs * Iic, XUartPs Uart_PS, char * RecvBuffer, int time_
 		}
 	}//END OF WHILE DONE != 1
 
+	//don't leave the DMA running into the landing zones after the run
+	DMARingStop();
+
 	//here is where we should transfer the CPS, 2DH files?
 	status_SOH = Save2DHToSD( PMT_ID_0 );
 	if(status_SOH != CMD_SUCCESS)
@@ -869,16 +1778,12 @@ int DataAcquisition( XIicPs * Iic, XUartPs Uart_PS, char * RecvBuffer, int time_
 	if(status_SOH != CMD_SUCCESS)
 		xil_printf("12 save sd 3 DAQ\n");
 
-	//TESTING 6-13-2019
-#ifdef PRODUCE_RAW_DATA
-//	sd_updateFileRecords("raw_data.bin", file_size(&m_raw_data_file));
-	f_close(&m_raw_data_file);
-#endif
-	//TESTING 6-13-2019
+	if(CloseRawDataFile() != CMD_SUCCESS)
+		xil_printf("14 error closing raw DAQ\n");
 
 	//cleanup operations
 	//2DH files are closed by that module
-	f_close(&m_EVT_file);
+	CloseEVTFiles();
 	f_close(&m_CPS_file);
 
 	return status;
@@ -9,6 +9,7 @@
 #define SRC_DATAACQUISITION_H_
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <xil_io.h>
 #include "xil_cache.h"
@@ -22,10 +23,16 @@
 #include "lunah_utils.h"
 #include "SetInstrumentParam.h"
 #include "ReadCommandType.h"
+#include "DMAControl.h"
+#include "EVTCompact.h"
+#include "EVTCompress.h"
 
 //Interrupt Variables
 extern XScuGic InterruptController;		// Interrupt controller
 
+int SetDAQOption( int option, int value );
+int GetDAQOption( int option );
+int GetRunDCacheMode( void );
 char *GetFolderName( void );
 int GetFolderNameSize( void );
 char *GetFileName( int file_type );
@@ -38,10 +45,30 @@ int DoesFileExist( void );
 int CreateDAQFiles( void );
 FIL *GetEVTFilePointer( void );
 FIL *GetCPSFilePointer( void );
+int OpenEVTHeaderFile( FIL * evt_file, char * filename );
+int WriteEVTDataEnd( FIL * evt_file );
+int PreallocateEVTFile( FIL * evt_file );
+int CloseEVTFile( FIL * evt_file );
+int PrepareNextEVTFile( void );
+int RolloverEVTFile( void );
+int CloseEVTFiles( void );
 FIL *Get2DHFilePointer( void );
+int WriteCPSRecords( int force );
+int OpenRawDataFile( void );
+void CaptureRawBuffer( unsigned int * data_raw, int run_seconds );
+int WriteRawBatches( int flush );
+int CloseRawDataFile( void );
+void UpdateFooterStatistics( void );
+int DrainWriteQueue( int max_blocks );
+int DrainAllEVTBlocks( void );
+unsigned int GetEVTQueueHighWater( void );
+unsigned int GetEVTQueueOverflows( void );
+unsigned int GetCPSQueueHighWater( void );
+unsigned int GetCPSQueueOverflows( void );
+unsigned int GetRawQueueHighWater( void );
+unsigned int GetRawQueueOverflows( void );
 int WriteRealTime( unsigned long long int real_time );
 void ClearBRAMBuffers( void );
-void DAQReadDataIn( unsigned int *raw_array, int buffer_number );
 int DataAcquisition( XIicPs * Iic, XUartPs Uart_PS, char * RecvBuffer, int time_out );
 
 #endif /* SRC_DATAACQUISITION_H_ */
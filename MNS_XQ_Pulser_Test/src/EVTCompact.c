@@ -0,0 +1,127 @@
+/*
+ * EVTCompact.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ */
+
+#include "EVTCompact.h"
+
+/*
+ * Write a value as a varint, 7 bits per byte, least significant group first.
+ *
+ * @param	(unsigned char *) where to write
+ * @param	(unsigned int) the value
+ *
+ * @return	(unsigned int) the number of bytes written, 1 -> 5
+ */
+static unsigned int PutVarint( unsigned char * out, unsigned int value )
+{
+	unsigned int bytes = 0;
+
+	while(value >= 0x80)
+	{
+		out[bytes++] = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
+	out[bytes++] = (unsigned char)value;
+
+	return bytes;
+}
+
+/*
+ * Encode an EVT block of 8 byte events in the compact format, see EVTCompact.h.
+ * The encoding stops if the output would grow past out_size, so passing the size of the standard
+ *  block means a compact block is only used when it is the smaller of the two.
+ *
+ * @param	(const unsigned char *) the events, 8 bytes each, as ProcessData() packs them
+ * @param	(unsigned int) the number of events
+ * @param	(unsigned char *) the output buffer, the header and the records go here
+ * @param	(unsigned int) the size of the output buffer
+ *
+ * @return	(unsigned int) the bytes written including the header, 0 if the block did not fit or
+ * 			held an event this format can't represent
+ */
+unsigned int EVTCompactEncodeBlock( const unsigned char * events, unsigned int num_events, unsigned char * out, unsigned int out_size )
+{
+	EVT_COMPACT_HEADER_TYPE * header = (EVT_COMPACT_HEADER_TYPE *)out;
+	const unsigned char * evt = NULL;
+	unsigned int pos = sizeof(EVT_COMPACT_HEADER_TYPE);
+	unsigned int iter = 0;
+	unsigned int time = 0;
+	unsigned int prev_time = 0;
+	unsigned int number = 0;
+	unsigned int prev_number = 0;
+	unsigned int delta_number = 0;
+	unsigned int energy = 0;
+	unsigned int since_sync = EVT_COMPACT_SYNC_EVENTS;	//start every block with a sync record
+
+	if(out_size < sizeof(EVT_COMPACT_HEADER_TYPE))
+		return 0;
+
+	for(iter = 0; iter < num_events; iter++)
+	{
+		evt = &events[iter * EVT_EVENT_SIZE];
+		if(pos + EVT_COMPACT_MAX_RECORD > out_size)
+			return 0;
+
+		switch(evt[0])
+		{
+		case 0xFF:
+			//data event
+			time = ((unsigned int)evt[5] << 16) | ((unsigned int)evt[6] << 8) | (unsigned int)evt[7];
+			number = (((unsigned int)evt[1] & 0x0F) << 8) | (unsigned int)evt[2];
+			if(since_sync >= EVT_COMPACT_SYNC_EVENTS || time < prev_time)
+			{
+				out[pos++] = EVT_COMPACT_SYNC << 6;
+				out[pos++] = evt[5];
+				out[pos++] = evt[6];
+				out[pos++] = evt[7];
+				out[pos++] = (unsigned char)(number >> 8);
+				out[pos++] = (unsigned char)(number & 0xFF);
+				prev_time = time;
+				prev_number = number;
+				since_sync = 0;
+			}
+			delta_number = (number - prev_number) & 0x0FFF;
+			energy = ((unsigned int)evt[3] << 1) | ((unsigned int)evt[4] >> 7);
+
+			out[pos++] = (unsigned char)((EVT_COMPACT_DATA << 6) | ((evt[4] >> 1) & 0x3F));
+			out[pos++] = (unsigned char)(energy & 0xFF);
+			out[pos++] = (unsigned char)(((energy >> 8) << 7) | ((evt[4] & 0x01) << 6) | ((evt[1] >> 4) << 2) | (delta_number <= 3 ? delta_number : 0));
+			pos += PutVarint(&out[pos], time - prev_time);
+			if(delta_number == 0 || delta_number > 3)
+				pos += PutVarint(&out[pos], delta_number);
+
+			prev_time = time;
+			prev_number = number;
+			since_sync++;
+			break;
+		case 0xEE:
+			//pulser event
+			out[pos++] = EVT_COMPACT_PULSER << 6;
+			out[pos++] = evt[5];
+			out[pos++] = evt[6];
+			out[pos++] = evt[7];
+			break;
+		case 0xDD:
+			//false event
+			out[pos++] = EVT_COMPACT_FALSE << 6;
+			out[pos++] = evt[5];
+			out[pos++] = evt[6];
+			out[pos++] = evt[7];
+			break;
+		default:
+			//not something ProcessData() writes, leave the block in the standard format
+			return 0;
+		}
+	}
+
+	header->eventID1 = 0xBC;
+	header->eventID2 = 0xBC;
+	header->eventID3 = 0xBC;
+	header->eventID4 = 0xBC;
+	header->num_bytes = pos - sizeof(EVT_COMPACT_HEADER_TYPE);
+
+	return pos;
+}
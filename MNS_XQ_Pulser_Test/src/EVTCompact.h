@@ -0,0 +1,57 @@
+/*
+ * EVTCompact.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ *
+ * The compact EVT format (EVT_FORMAT_COMPACT). Each EVT block of 8 byte events is re-encoded as
+ *  a stream of variable length records behind an EVT_COMPACT_HEADER_TYPE. Data events keep all of
+ *  their fields, but the time and event number are stored as deltas from the event before, which
+ *  for most events brings them down to 4 bytes.
+ *
+ * Each record starts with a byte whose top two bits give the record type:
+ * 	EVT_COMPACT_DATA	byte 0 = type | PSD bin (6 bits)
+ * 						byte 1 = energy bin, low 8 bits
+ * 						byte 2 = energy bin bit 8 (bit 7) | tagging bit (bit 6) | PMT ID (bits 5-2) | event number delta (bits 1-0)
+ * 						varint = time delta, in units of the EVT time field
+ * 						varint = event number delta, only if bits 1-0 of byte 2 are 0
+ * 	EVT_COMPACT_PULSER	byte 0 = type, then the 3 time bytes of the 0xEE event
+ * 	EVT_COMPACT_FALSE	byte 0 = type, then the 3 time bytes of the 0xDD event
+ * 	EVT_COMPACT_SYNC	byte 0 = type, then the absolute 3 byte time and 2 byte event number which
+ * 						the next data event's deltas are taken from
+ * A varint is 7 bits per byte, least significant group first, the top bit set on every byte but
+ *  the last. The event number delta wraps at 12 bits. A sync record starts every block, so each
+ *  block decodes on its own, and is repeated every EVT_COMPACT_SYNC_EVENTS data events and
+ *  whenever the time goes backwards.
+ */
+
+#ifndef SRC_EVTCOMPACT_H_
+#define SRC_EVTCOMPACT_H_
+
+#include <stddef.h>
+#include "lunah_defines.h"
+
+//record types, the top two bits of the first byte of each record
+#define EVT_COMPACT_DATA	0
+#define EVT_COMPACT_PULSER	1
+#define EVT_COMPACT_FALSE	2
+#define EVT_COMPACT_SYNC	3
+#define EVT_COMPACT_MAX_RECORD	15	//a sync record, then a data event with the largest deltas
+
+/*
+ * A compact EVT block starts with this header, the records follow it.
+ * The markers tell it apart from a standard block (EVT_BLOCK_HEADER_TYPE, 0xBB) which is written
+ *  in its place when a block would not come out any smaller.
+ */
+typedef struct {
+	unsigned char eventID1;		//0xBC
+	unsigned char eventID2;		//0xBC
+	unsigned char eventID3;		//0xBC
+	unsigned char eventID4;		//0xBC
+	unsigned int num_bytes;		//bytes of records which follow this header
+}EVT_COMPACT_HEADER_TYPE;
+
+// prototypes
+unsigned int EVTCompactEncodeBlock( const unsigned char * events, unsigned int num_events, unsigned char * out, unsigned int out_size );
+
+#endif /* SRC_EVTCOMPACT_H_ */
@@ -0,0 +1,285 @@
+/*
+ * EVTCompress.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ */
+
+#include <string.h>
+#include "EVTCompress.h"
+
+/*
+ * Fletcher-32 over bytes. The sums are only reduced every 2048 bytes, which is as long as they
+ *  can go without overflowing, so there is no modulo per byte.
+ *
+ * @param	(const unsigned char *) the data
+ * @param	(unsigned int) the number of bytes
+ *
+ * @return	(unsigned int) the checksum, sum2 in the high 16 bits
+ */
+unsigned int EVTCompressChecksum( const unsigned char * data, unsigned int num_bytes )
+{
+	unsigned int sum1 = 0;
+	unsigned int sum2 = 0;
+	unsigned int run = 0;
+
+	while(num_bytes > 0)
+	{
+		run = num_bytes > 2048 ? 2048 : num_bytes;
+		num_bytes -= run;
+		while(run > 0)
+		{
+			sum1 += *data++;
+			sum2 += sum1;
+			run--;
+		}
+		sum1 %= 65535;
+		sum2 %= 65535;
+	}
+
+	return (sum2 << 16) | sum1;
+}
+
+/*
+ * Pick the Rice parameter for one byte plane from the sum of its (zigzagged) differences.
+ * 2^k is close to the mean difference.
+ */
+static unsigned int RiceParameter( unsigned int sum, unsigned int count )
+{
+	unsigned int k = 0;
+
+	while(k < EVT_RICE_MAX_K && (count << (k + 1)) <= sum)
+		k++;
+
+	return k;
+}
+
+/*
+ * Compress an EVT block, see EVTCompress.h.
+ * If the compressed block would be no smaller than the raw block it is stored instead, so the
+ *  output is never more than the raw block plus the header.
+ *
+ * @param	(const unsigned char *) the raw block
+ * @param	(unsigned int) the size of the raw block
+ * @param	(unsigned int) the number of byte planes, the record size of the block, 1 -> EVT_COMPRESS_MAX_STRIDE
+ * @param	(unsigned char *) the output buffer
+ * @param	(unsigned int) the size of the output buffer, at least raw_bytes + sizeof(EVT_COMPRESS_HEADER_TYPE)
+ *
+ * @return	(unsigned int) the bytes written including the header, 0 if the output buffer is too small
+ */
+unsigned int EVTCompressBlock( const unsigned char * raw, unsigned int raw_bytes, unsigned int stride, unsigned char * out, unsigned int out_size )
+{
+	EVT_COMPRESS_HEADER_TYPE header;
+	unsigned char * data = out + sizeof(EVT_COMPRESS_HEADER_TYPE);
+	unsigned char prev = 0;
+	unsigned int k[EVT_COMPRESS_MAX_STRIDE] = {};
+	unsigned int sum = 0;
+	unsigned int count = 0;
+	unsigned int plane = 0;
+	unsigned int iter = 0;
+	unsigned int zz = 0;
+	unsigned int q = 0;
+	unsigned int limit = raw_bytes;		//give up on compression once we are this big
+	unsigned int pos = 0;
+	unsigned int bit_buff = 0;			//bits waiting to go out, most significant first
+	int bit_count = 0;
+	int stored = 0;
+
+	if(out_size < raw_bytes + sizeof(EVT_COMPRESS_HEADER_TYPE))
+		return 0;
+	if(stride < 1 || stride > EVT_COMPRESS_MAX_STRIDE)
+		stride = 1;
+
+	header.eventID1 = 0xBD;
+	header.eventID2 = 0xBD;
+	header.stride = (unsigned char)stride;
+	header.raw_bytes = raw_bytes;
+	header.checksum = EVTCompressChecksum(raw, raw_bytes);
+
+	//one Rice parameter for each plane
+	for(plane = 0; plane < stride; plane++)
+	{
+		prev = 0;
+		sum = 0;
+		count = 0;
+		for(iter = plane; iter < raw_bytes; iter += stride)
+		{
+			zz = (unsigned char)(raw[iter] - prev);
+			zz = (zz & 0x80) ? ((~zz & 0x7F) << 1) | 1 : zz << 1;
+			sum += zz;
+			count++;
+			prev = raw[iter];
+		}
+		k[plane] = RiceParameter(sum, count);
+		if(pos < limit)
+			data[pos++] = (unsigned char)k[plane];
+	}
+
+	for(plane = 0; plane < stride && stored == 0; plane++)
+	{
+		prev = 0;
+		for(iter = plane; iter < raw_bytes; iter += stride)
+		{
+			//difference from the last byte of the plane, zigzagged so small changes either way are small
+			zz = (unsigned char)(raw[iter] - prev);
+			zz = (zz & 0x80) ? ((~zz & 0x7F) << 1) | 1 : zz << 1;
+			prev = raw[iter];
+
+			//each code word goes in with one shift, at most 16 bits
+			q = zz >> k[plane];
+			if(q < EVT_RICE_ESCAPE)
+			{
+				//q ones, a zero, then the low k bits
+				bit_buff = (bit_buff << (q + 1 + k[plane])) | ((((1u << q) - 1) << (1 + k[plane])) | (zz & ((1u << k[plane]) - 1)));
+				bit_count += q + 1 + k[plane];
+			}
+			else
+			{
+				//escape, then the whole value
+				bit_buff = (bit_buff << (EVT_RICE_ESCAPE + 8)) | ((((1u << EVT_RICE_ESCAPE) - 1) << 8) | zz);
+				bit_count += EVT_RICE_ESCAPE + 8;
+			}
+			//whole bytes go out, the buffer never holds more than 7 + 16 bits
+			while(bit_count >= 8)
+			{
+				bit_count -= 8;
+				if(pos >= limit)
+				{
+					stored = 1;
+					break;
+				}
+				data[pos++] = (unsigned char)(bit_buff >> bit_count);
+			}
+			if(stored == 1)
+				break;
+		}
+	}
+	if(stored == 0 && bit_count > 0)
+	{
+		if(pos >= limit)
+			stored = 1;
+		else
+			data[pos++] = (unsigned char)(bit_buff << (8 - bit_count));
+	}
+
+	if(stored == 1 || pos >= limit)
+	{
+		header.method = EVT_COMPRESS_STORED;
+		header.comp_bytes = raw_bytes;
+		memcpy(data, raw, raw_bytes);
+	}
+	else
+	{
+		header.method = EVT_COMPRESS_RICE;
+		header.comp_bytes = pos;
+	}
+	memcpy(out, &header, sizeof(header));
+
+	return sizeof(EVT_COMPRESS_HEADER_TYPE) + header.comp_bytes;
+}
+
+/*
+ * Unpack a block written by EVTCompressBlock() and check it against its checksum.
+ *
+ * @param	(const unsigned char *) the compressed block, starting at its header
+ * @param	(unsigned int) the bytes available at in
+ * @param	(unsigned char *) the output buffer
+ * @param	(unsigned int) the size of the output buffer
+ *
+ * @return	(unsigned int) the size of the raw block, 0 if the block is damaged or does not fit
+ */
+unsigned int EVTDecompressBlock( const unsigned char * in, unsigned int in_bytes, unsigned char * out, unsigned int out_size )
+{
+	EVT_COMPRESS_HEADER_TYPE header;
+	const unsigned char * data = in + sizeof(EVT_COMPRESS_HEADER_TYPE);
+	unsigned int k[EVT_COMPRESS_MAX_STRIDE] = {};
+	unsigned int plane = 0;
+	unsigned int iter = 0;
+	unsigned int pos = 0;
+	unsigned int bit_pos = 0;		//next bit to read, counting from the first bit after the parameters
+	unsigned int total_bits = 0;
+	unsigned int q = 0;
+	unsigned int zz = 0;
+	unsigned int bits = 0;
+	unsigned char prev = 0;
+
+	if(in_bytes < sizeof(EVT_COMPRESS_HEADER_TYPE))
+		return 0;
+	memcpy(&header, in, sizeof(header));
+	if(header.eventID1 != 0xBD || header.eventID2 != 0xBD)
+		return 0;
+	if(header.stride < 1 || header.stride > EVT_COMPRESS_MAX_STRIDE)
+		return 0;
+	if(header.raw_bytes > out_size || header.comp_bytes > in_bytes - sizeof(EVT_COMPRESS_HEADER_TYPE))
+		return 0;
+
+	if(header.method == EVT_COMPRESS_STORED)
+	{
+		if(header.comp_bytes != header.raw_bytes)
+			return 0;
+		memcpy(out, data, header.raw_bytes);
+	}
+	else if(header.method == EVT_COMPRESS_RICE)
+	{
+		if(header.comp_bytes < header.stride)
+			return 0;
+		for(plane = 0; plane < header.stride; plane++)
+		{
+			k[plane] = data[plane];
+			if(k[plane] > EVT_RICE_MAX_K)
+				return 0;
+		}
+		pos = header.stride;
+		total_bits = (header.comp_bytes - pos) * 8;
+
+		for(plane = 0; plane < header.stride; plane++)
+		{
+			prev = 0;
+			for(iter = plane; iter < header.raw_bytes; iter += header.stride)
+			{
+				//count the ones, up to the escape
+				q = 0;
+				while(q < EVT_RICE_ESCAPE)
+				{
+					if(bit_pos >= total_bits)
+						return 0;
+					if(((data[pos + (bit_pos >> 3)] >> (7 - (bit_pos & 7))) & 1) == 0)
+						break;
+					q++;
+					bit_pos++;
+				}
+				if(q < EVT_RICE_ESCAPE)
+				{
+					bit_pos++;	//the zero
+					bits = k[plane];
+					zz = q << bits;
+				}
+				else
+				{
+					bits = 8;
+					zz = 0;
+				}
+				if(bit_pos + bits > total_bits)
+					return 0;
+				while(bits > 0)
+				{
+					bits--;
+					zz |= ((data[pos + (bit_pos >> 3)] >> (7 - (bit_pos & 7))) & 1) << bits;
+					bit_pos++;
+				}
+				if(zz > 0xFF)
+					return 0;
+				//undo the zigzag and the difference
+				prev = (unsigned char)(prev + ((zz & 1) ? ~(zz >> 1) : (zz >> 1)));
+				out[iter] = prev;
+			}
+		}
+	}
+	else
+		return 0;
+
+	if(EVTCompressChecksum(out, header.raw_bytes) != header.checksum)
+		return 0;
+
+	return header.raw_bytes;
+}
@@ -0,0 +1,56 @@
+/*
+ * EVTCompress.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ *
+ * Lossless compression of EVT blocks before they are written to the SD card.
+ * The block is split into byte planes (plane p is every stride-th byte starting at byte p, so
+ *  for 8 byte events each event field gets its own plane), each byte is replaced by its difference
+ *  from the byte before it in the same plane, and the differences are Rice coded with a parameter
+ *  picked for each plane. Event fields change slowly from one event to the next, so most of the
+ *  differences are small and take only a few bits.
+ * Each compressed block sits behind an EVT_COMPRESS_HEADER_TYPE which carries the raw length and
+ *  a checksum of the raw bytes. A block which would not get smaller is stored as it is.
+ *
+ * This file and EVTCompress.c only use standard C so that ground tools can build them as they are
+ *  and use EVTDecompressBlock() to unpack the EVT files.
+ *
+ * host_tests/EVTCompressTest.c is the round trip test and the host benchmark. On the board, stage 6
+ *  of MNS_PROFILE (DAQ_STAGE_COMPRESS, the line starting "6_") is the time per EVT block. To keep up,
+ *  that has to be shorter than the time the FPGA takes to fill the DMA buffers of one block at the
+ *  highest event rate.
+ */
+
+#ifndef SRC_EVTCOMPRESS_H_
+#define SRC_EVTCOMPRESS_H_
+
+#include <stddef.h>
+
+#define EVT_COMPRESS_STORED		0	//the raw bytes follow the header
+#define EVT_COMPRESS_RICE		1	//byte plane delta and Rice coding
+#define EVT_COMPRESS_MAX_STRIDE	8	//the most byte planes
+#define EVT_RICE_MAX_K			7	//largest Rice parameter for a byte
+#define EVT_RICE_ESCAPE			8	//this many 1s in a row means the next 8 bits are the value as it is
+
+/*
+ * Header for a compressed EVT block, the compressed bytes follow it.
+ * For EVT_COMPRESS_RICE the data starts with one Rice parameter byte for each plane, then the
+ *  bits for plane 0, 1, ... one after the other, most significant bit first.
+ */
+typedef struct {
+	unsigned char eventID1;		//0xBD
+	unsigned char eventID2;		//0xBD
+	unsigned char method;		//EVT_COMPRESS_#
+	unsigned char stride;		//number of byte planes, 1 -> EVT_COMPRESS_MAX_STRIDE
+	unsigned int raw_bytes;		//size of the block before compression
+	unsigned int comp_bytes;	//bytes which follow this header
+	unsigned int checksum;		//Fletcher-32 of the raw bytes
+}EVT_COMPRESS_HEADER_TYPE;
+
+// prototypes
+unsigned int EVTCompressChecksum( const unsigned char * data, unsigned int num_bytes );
+unsigned int EVTCompressBlock( const unsigned char * raw, unsigned int raw_bytes, unsigned int stride, unsigned char * out, unsigned int out_size );
+unsigned int EVTDecompressBlock( const unsigned char * in, unsigned int in_bytes, unsigned char * out, unsigned int out_size );
+
+#endif /* SRC_EVTCOMPRESS_H_ */
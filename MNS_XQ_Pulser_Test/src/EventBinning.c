@@ -0,0 +1,347 @@
+/*
+ * EventBinning.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ */
+
+#include "EventBinning.h"
+
+//binning tables for the current configuration, see BinningUpdate()
+//the bin widths never change, they are filled in here so the double path works before the first BinningUpdate()
+static EVENT_BINNING_TYPE m_binning = {
+		.energy_bin_width = (double)TWODH_ENERGY_MAX / (double)TWODH_X_BINS,
+		.psd_bin_width = (double)TWODH_PSD_MAX / (double)TWODH_Y_BINS
+};
+
+/*
+ * Build the binning tables for a set of integration times. This is called whenever the integration
+ *  times are set, so that nothing which depends only on the configuration is worked out per event.
+ * If the integration times would overflow the 64-bit integer math, the integer tables are marked
+ *  invalid and every event is binned with the double precision path.
+ *
+ * @param	(int) the baseline, short, long, and full integration times in samples
+ *
+ * @return	None
+ */
+void BinningUpdate( int baseline_samples, int short_samples, int long_samples, int full_samples )
+{
+	EVENT_BINNING_TYPE * tables = &m_binning;
+	int bin = 0;
+
+	tables->valid = 0;
+	tables->baseline_scale = 4LL * (long long)baseline_samples;
+	tables->short_samples = (long long)short_samples;
+	tables->long_samples = (long long)long_samples;
+	tables->full_samples = (long long)full_samples;
+	tables->energy_den = 64LL * (long long)baseline_samples * (long long)TWODH_ENERGY_MAX;
+	tables->psd_max = (long long)TWODH_PSD_MAX;
+	tables->psd_top_step = 1;
+	while(tables->psd_top_step * 2 < TWODH_Y_BINS)
+		tables->psd_top_step *= 2;
+
+	tables->baseline_samples_d = (double)baseline_samples;
+	tables->short_samples_d = (double)short_samples;
+	tables->long_samples_d = (double)long_samples;
+	tables->full_samples_d = (double)full_samples;
+	tables->energy_bin_width = (double)TWODH_ENERGY_MAX / (double)TWODH_X_BINS;
+	tables->psd_bin_width = (double)TWODH_PSD_MAX / (double)TWODH_Y_BINS;
+	tables->bad_psd_bin = (int)floor(1.999 / tables->psd_bin_width);
+
+	//the baseline must be at least one sample, and the full integral short enough to keep
+	// samples * 4 * 2^32 and the bin products inside of a signed 64-bit integer
+	if(baseline_samples < 1 || full_samples > FIXED_POINT_MAX_SAMPLES)
+		return;
+	if((double)tables->psd_max != (double)TWODH_PSD_MAX)
+		return;
+	tables->energy_den_inv = 1.0 / (double)tables->energy_den;
+	for(bin = 0; bin <= TWODH_X_BINS; bin++)
+		tables->energy_edges[bin] = (long long)bin * tables->energy_den;
+	tables->valid = 1;
+
+	return;
+}
+
+/*
+ * Exact energy bin, floor(num / energy_den), along with a check that the double precision math
+ *  ProcessData() used to use would have found the same bin, see FixedPointBin().
+ * The reciprocal gives a bin which is at most one off, the edge table then moves it onto the bin
+ *  whose edges hold num, so there is no divide per event.
+ *
+ * @param	(EVENT_BINNING_TYPE *) the tables for the current configuration
+ * @param	(long long) the numerator, N_full * TWODH_X_BINS, may be negative
+ * @param	(long long) the largest error of the double path, in units of num
+ *
+ * @return	(int) the bin, -1 if below the first bin, TWODH_X_BINS if past the last bin,
+ * 			FIXED_BIN_UNSAFE if the double path might not agree
+ */
+static int FixedPointEnergyBin( EVENT_BINNING_TYPE * tables, long long num, long long margin )
+{
+	int bin = 0;
+
+	if(num < 0)
+	{
+		if(-num > margin)
+			return -1;
+		return FIXED_BIN_UNSAFE;
+	}
+	if(num >= tables->energy_edges[TWODH_X_BINS])
+	{
+		if(num - tables->energy_edges[TWODH_X_BINS] > margin)
+			return TWODH_X_BINS;
+		return FIXED_BIN_UNSAFE;
+	}
+	bin = (int)((double)num * tables->energy_den_inv);
+	if(bin > TWODH_X_BINS - 1)
+		bin = TWODH_X_BINS - 1;
+	while(bin > 0 && num < tables->energy_edges[bin])
+		bin--;
+	while(num >= tables->energy_edges[bin + 1])
+		bin++;
+	if(num - tables->energy_edges[bin] <= margin || tables->energy_edges[bin + 1] - num <= margin)
+		return FIXED_BIN_UNSAFE;
+
+	return bin;
+}
+
+/*
+ * Exact floor(num / den) for a bin index, along with a check that the double precision math
+ *  ProcessData() used to use would have found the same bin.
+ * The double result can be off from the exact value by at most margin (in units of num), so the
+ *  bins can only differ when the exact value sits within margin of a bin edge.
+ * This is used for the PSD bin, den changes with each event so the bin is found by stepping
+ *  through the edges (log2 of num_bins compares).
+ *
+ * @param	(long long) the numerator, may be negative
+ * @param	(long long) the denominator, > 0
+ * @param	(int) the number of bins
+ * @param	(int) the largest power of two below num_bins
+ * @param	(long long) the largest error of the double path, in units of num
+ *
+ * @return	(int) the bin, -1 if below the first bin, num_bins if past the last bin,
+ * 			FIXED_BIN_UNSAFE if the double path might not agree
+ */
+static int FixedPointBin( long long num, long long den, int num_bins, int top_step, long long margin )
+{
+	int bin = 0;
+	int step = 0;
+
+	if(num < 0)
+	{
+		if(-num > margin)
+			return -1;
+		return FIXED_BIN_UNSAFE;
+	}
+	if(num >= den * num_bins)
+	{
+		if(num - den * num_bins > margin)
+			return num_bins;
+		return FIXED_BIN_UNSAFE;
+	}
+	//restoring division, the quotient is less than num_bins
+	for(step = top_step; step > 0; step >>= 1)
+	{
+		if(num >= den * step)
+		{
+			num -= den * step;
+			bin += step;
+		}
+	}
+	if(num <= margin || den - num <= margin)
+		return FIXED_BIN_UNSAFE;
+
+	return bin;
+}
+
+/*
+ * Find the energy and PSD bins of an event with 64-bit integer math, see EVENT_BINNING_TYPE.
+ * The bins are the same as the double precision path gives: if the event is close enough to a
+ *  bin edge (or to one of the PSD sanity checks) that rounding in the doubles could have moved it,
+ *  nothing is changed and FIXED_BIN_UNSAFE is returned so that the caller can use the doubles.
+ *  This is rare, only events which land almost exactly on an edge.
+ *
+ * The double path's error bound: each integral is raw/16 - avg * samples, where avg is the mean of
+ *  four rounded quotients (at most 4 roundings), which the doubles get within 7 * 2^-53 * (raw/16 + avg * samples), which is less than 2^-50 * (4B * raw + samples * R)
+ *  in units of 1/D. The PSD and energy divisions add one rounding each on top of that.
+ *
+ * @param	(EVENT_BINNING_TYPE *) the tables for the current configuration
+ * @param	(unsigned long long) the sum of the last four raw baseline integrals
+ * @param	(unsigned int) the raw short, long, full integrals
+ * @param	(int *) the PSD bin, set when the return is not FIXED_BIN_UNSAFE
+ * @param	(bool *) set TRUE if the PSD value is bad
+ *
+ * @return	(int) the energy bin, or FIXED_BIN_UNSAFE
+ */
+static int FixedPointBins( EVENT_BINNING_TYPE * scales, unsigned long long baseline_sum,
+		unsigned int raw_short, unsigned int raw_long, unsigned int raw_full, int * psd_bin, bool * bad_psd )
+{
+	int energy_bin = 0;
+	int new_psd_bin = 0;
+	int psd_good = 0;
+	long long sum_rb = (long long)baseline_sum;
+	long long n_short = 0;
+	long long n_long = 0;
+	long long n_full = 0;
+	long long err_short = 0;
+	long long err_long = 0;
+	long long err_full = 0;
+	long long num = 0;
+	long long den = 0;
+
+	n_short = scales->baseline_scale * (long long)raw_short - scales->short_samples * sum_rb;
+	n_long = scales->baseline_scale * (long long)raw_long - scales->long_samples * sum_rb;
+	n_full = scales->baseline_scale * (long long)raw_full - scales->full_samples * sum_rb;
+	err_short = ((scales->baseline_scale * (long long)raw_short + scales->short_samples * sum_rb) >> 50) + 1;
+	err_long = ((scales->baseline_scale * (long long)raw_long + scales->long_samples * sum_rb) >> 50) + 1;
+	err_full = ((scales->baseline_scale * (long long)raw_full + scales->full_samples * sum_rb) >> 50) + 1;
+
+	//energy = floor(fi / (TWODH_ENERGY_MAX / TWODH_X_BINS))
+	num = n_full * TWODH_X_BINS;
+	energy_bin = FixedPointEnergyBin(scales, num, err_full * TWODH_X_BINS + ((num < 0 ? -num : num) >> 50) + 1);
+	if(energy_bin == FIXED_BIN_UNSAFE)
+		return FIXED_BIN_UNSAFE;
+
+	//li, si must be positive, li greater than si, the doubles have to agree on each test
+	if(n_long > -err_long && n_long < err_long)
+		return FIXED_BIN_UNSAFE;
+	if(n_short > -err_short && n_short < err_short)
+		return FIXED_BIN_UNSAFE;
+	if(n_long - n_short > -(err_long + err_short) && n_long - n_short < err_long + err_short)
+		return FIXED_BIN_UNSAFE;
+	psd_good = (n_long > 0 && n_short > 0 && n_long > n_short);
+	if(psd_good)
+	{
+		//psd = floor((si / (li - si)) / (TWODH_PSD_MAX / TWODH_Y_BINS))
+		num = n_short * TWODH_Y_BINS;
+		den = (n_long - n_short) * scales->psd_max;
+		new_psd_bin = FixedPointBin(num, den, TWODH_Y_BINS, scales->psd_top_step,
+				TWODH_Y_BINS * ((1 + scales->psd_max) * err_short + scales->psd_max * err_long) + (num >> 50) + 2);
+		if(new_psd_bin == FIXED_BIN_UNSAFE)
+			return FIXED_BIN_UNSAFE;
+	}
+	else
+	{
+		new_psd_bin = scales->bad_psd_bin;
+		*bad_psd = TRUE;
+	}
+
+	*psd_bin = new_psd_bin;
+	return energy_bin;
+}
+
+/*
+ * Find the energy and PSD bins for an event with the double precision math ProcessData() has
+ *  always used, operation for operation, so an event on a bin edge rounds the way it always did.
+ *  This is the reference the integer path has to agree with, it is only run for the events which
+ *  sit too close to a bin edge for the integer path to be sure.
+ */
+static int DoubleBins( EVENT_BINNING_TYPE * tables, int baseline_channel, unsigned int raw_short, unsigned int raw_long,
+		unsigned int raw_full, int * psd_bin, bool * bad_psd )
+{
+	unsigned int history[BASELINE_HISTORY_SIZE];
+	double bl_avg = 0.0;
+	double si = 0.0;
+	double li = 0.0;
+	double fi = 0.0;
+	double psd = 0.0;
+
+	//the moving average of the baseline integral, per sample, oldest integral first
+	if(BaselineGetHistory(baseline_channel, history) == BASELINE_HISTORY_SIZE)
+		bl_avg = ((double)history[3] / (16.0 * tables->baseline_samples_d) + (double)history[2] / (16.0 * tables->baseline_samples_d)
+				+ (double)history[1] / (16.0 * tables->baseline_samples_d) + (double)history[0] / (16.0 * tables->baseline_samples_d)) / 4.0;
+	else
+		bl_avg = (double)history[0] / (16.0 * tables->baseline_samples_d);
+	//calculate the baseline corrected integrals from the event
+	si = ((double)raw_short) / (16.0) - (bl_avg * tables->short_samples_d);
+	li = ((double)raw_long) / (16.0) - (bl_avg * tables->long_samples_d);
+	fi = ((double)raw_full) / (16.0) - (bl_avg * tables->full_samples_d);
+
+	//li, si must be positive, li greater than si (ensures positive psd values and li != si)
+	if( li > 0 && si > 0 && li > si)
+		psd = si / (li - si);
+	else
+	{
+		psd = 1.999;	//set to highest good bin
+		*bad_psd = TRUE;
+	}
+	//calculate the "bin space" values of the energy and PSD
+	*psd_bin = (int)floor(psd / tables->psd_bin_width);
+	return (int)floor(fi / tables->energy_bin_width);
+}
+
+/*
+ * Find the energy and PSD bins for an event.
+ * The integer path is used whenever it is sure to agree with the double precision path, which
+ *  is every event but those almost exactly on a bin edge. Bins outside of the 2DH are set to the
+ *  top bin (0x1FF energy, 0x3F PSD) so that they fit in the EVT event fields.
+ *
+ * @param	(int) the baseline channel of the event, see BaselineGetChannel()
+ * @param	(unsigned long long) the sum of the last four raw baseline integrals, see BaselineUpdate()
+ * @param	(unsigned int) the raw short, long, full integrals from the event
+ * @param	(int *) the energy bin
+ * @param	(int *) the PSD bin
+ *
+ * @return	(int) BINNING_# flags for anything wrong with the event, 0 if the event is fine
+ */
+int BinningFindBins( int baseline_channel, unsigned long long baseline_sum, unsigned int raw_short, unsigned int raw_long, unsigned int raw_full, int * energy_bin, int * psd_bin )
+{
+	bool bad_psd = FALSE;
+	int flags = 0;
+	int m_energy_bin = FIXED_BIN_UNSAFE;
+	int m_psd_bin = 0;
+
+	if(m_binning.valid == 1)
+		m_energy_bin = FixedPointBins(&m_binning, baseline_sum, raw_short, raw_long, raw_full, &m_psd_bin, &bad_psd);
+	if(m_energy_bin == FIXED_BIN_UNSAFE)
+	{
+		bad_psd = FALSE;
+		m_energy_bin = DoubleBins(&m_binning, baseline_channel, raw_short, raw_long, raw_full, &m_psd_bin, &bad_psd);
+	}
+
+	//generate the bin value to use
+	if(0 <= m_energy_bin && m_energy_bin < TWODH_X_BINS)
+		m_energy_bin &= 0x01FF;
+	else
+	{
+		m_energy_bin = 0x01FF;
+		flags |= BINNING_ENERGY_OUT;
+	}
+	if(0 <= m_psd_bin && m_psd_bin < TWODH_Y_BINS)
+		m_psd_bin &= 0x3F;	//move to 6 bits 10-11-2019
+	else
+		m_psd_bin = 0x3F;
+
+	*energy_bin = m_energy_bin;
+	*psd_bin = m_psd_bin;
+	if(bad_psd == TRUE)
+		flags |= BINNING_BAD_PSD;
+	return flags;
+}
+
+/*
+ * Check if a pair of bins is inside of the 2-D histogram.
+ *
+ * @param	(int) the energy bin
+ * @param	(int) the PSD bin
+ *
+ * @return	(bool) TRUE if both bins are inside of the 2DH
+ */
+bool BinningIsInRange( int energy_bin, int psd_bin )
+{
+	if(0 <= energy_bin && energy_bin < TWODH_X_BINS && 0 <= psd_bin && psd_bin < TWODH_Y_BINS)
+		return TRUE;
+	return FALSE;
+}
+
+/*
+ * Getter function for the number of PSD bins per unit of PSD, this scales a PSD value (or cut)
+ *  into bin space.
+ *
+ * @param	None
+ *
+ * @return	(double) TWODH_Y_BINS / TWODH_PSD_MAX
+ */
+double BinningGetPSDBinsPerUnit( void )
+{
+	return (double)TWODH_Y_BINS / (double)TWODH_PSD_MAX;
+}
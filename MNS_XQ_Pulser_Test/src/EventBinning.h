@@ -0,0 +1,64 @@
+/*
+ * EventBinning.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ *
+ * Maps the integrals from an event onto the energy and PSD bins used by the EVT, CPS, and 2DH
+ *  data products. Everything which depends on the configuration (integration times and the 2DH
+ *  binning) is worked out once by BinningUpdate() when the integration times are set, so the
+ *  per-event work is integer multiplies, compares, and subtracts.
+ * ProcessData(), Tally2DH(), and CPSUpdateTallies() all take their binning from here so that the
+ *  bin edges and the out-of-range rules only live in one place.
+ */
+
+#ifndef SRC_EVENTBINNING_H_
+#define SRC_EVENTBINNING_H_
+
+#include <stdbool.h>
+#include <math.h>
+#include "xil_types.h"
+#include "lunah_defines.h"
+#include "BaselineTracker.h"
+
+/*
+ * The binning tables for the current configuration.
+ * With the baseline history summed as R (four raw baseline integrals, or four times the newest
+ *  one, see BaselineUpdate()), each baseline corrected integral is N/D with N = 4*B*raw - samples*R and D = 64*B, where
+ *  B is the number of baseline samples. The energy bin is then floor(N_full * TWODH_X_BINS / energy_den)
+ *  and the PSD bin is floor(N_short * TWODH_Y_BINS / ((N_long - N_short) * psd_max)).
+ * The energy divisor only depends on the configuration, so the energy bin is estimated with its
+ *  reciprocal and then checked against the table of bin edges. The PSD divisor changes with each
+ *  event, so there is nothing to precompute and the PSD bin is found by stepping through the edges.
+ */
+typedef struct{
+	int valid;					//0 if the integration times are out of range for the integer path
+	long long baseline_scale;	//4 * baseline samples
+	long long short_samples;
+	long long long_samples;
+	long long full_samples;
+	long long energy_den;		//64 * baseline samples * TWODH_ENERGY_MAX
+	double energy_den_inv;		//1 / energy_den, for the first guess at the energy bin
+	long long energy_edges[TWODH_X_BINS + 1];	//the start of each energy bin, bin * energy_den
+	long long psd_max;			//TWODH_PSD_MAX as an integer
+	int psd_top_step;			//largest power of two below TWODH_Y_BINS
+	int bad_psd_bin;			//the bin an event with a bad PSD value gets (psd = 1.999)
+	double baseline_samples_d;	//the sample counts and bin widths for the double precision path
+	double short_samples_d;
+	double long_samples_d;
+	double full_samples_d;
+	double energy_bin_width;	//TWODH_ENERGY_MAX / TWODH_X_BINS
+	double psd_bin_width;		//TWODH_PSD_MAX / TWODH_Y_BINS
+}EVENT_BINNING_TYPE;
+
+//BinningFindBins() flags
+#define BINNING_BAD_PSD		0x01	//the short/long integrals failed the PSD sanity checks
+#define BINNING_ENERGY_OUT	0x02	//the energy was outside of the 2DH and was set to the top bin
+
+// prototypes
+void BinningUpdate( int baseline_samples, int short_samples, int long_samples, int full_samples );
+int BinningFindBins( int baseline_channel, unsigned long long baseline_sum, unsigned int raw_short, unsigned int raw_long, unsigned int raw_full, int * energy_bin, int * psd_bin );
+bool BinningIsInRange( int energy_bin, int psd_bin );
+double BinningGetPSDBinsPerUnit( void );
+
+#endif /* SRC_EVENTBINNING_H_ */
@@ -0,0 +1,377 @@
+/*
+ * MirrorFiles.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ */
+
+#include "MirrorFiles.h"
+
+static int m_mirror_rate = MIRROR_DEFAULT_RATE;	//KiB per second, 0 = mirror off
+//folders waiting to be copied, oldest at m_mirror_tail
+static char m_mirror_queue[MIRROR_QUEUE_DEPTH][MIRROR_PATH_SIZE];
+static XTime m_mirror_queue_time[MIRROR_QUEUE_DEPTH];			//when each folder was queued
+static unsigned int m_mirror_queue_bytes[MIRROR_QUEUE_DEPTH];	//bytes of each folder still to copy
+static int m_mirror_head;
+static int m_mirror_tail;
+static int m_mirror_count;
+static unsigned int m_mirror_bytes_waiting;	//bytes still to copy, all folders
+static unsigned int m_mirror_errors;		//folders or files which could not be copied
+//the copy in progress
+static DIR m_mirror_dir;
+static int m_mirror_dir_open;
+static FIL m_mirror_src;
+static FIL m_mirror_dst;
+static int m_mirror_file_open;
+static char m_mirror_src_name[MIRROR_PATH_SIZE + 260];	//the file being copied
+static char m_mirror_dst_name[MIRROR_PATH_SIZE + 260];
+static unsigned int m_mirror_file_bytes;	//bytes of the file being copied which are already on SD card 1
+static int m_mirror_retry;					//copy m_mirror_src_name again from the start before reading the next file
+static unsigned char m_mirror_buff[MIRROR_CHUNK_SIZE];
+//rate limiting
+static XTime m_mirror_last_service;
+static unsigned int m_mirror_allowance;		//bytes we may copy now
+
+/*
+ * Set the mirror rate. This is set with the MNS_MIRROR command.
+ * Folders keep being queued while the rate is 0, they are copied once the mirror is turned
+ *  back on.
+ *
+ * @param	(int) KiB per second to copy, 0 -> MIRROR_MAX_RATE, 0 turns the mirror off
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if the rate was out of range
+ */
+int MirrorSetRate( int kib_per_sec )
+{
+	if(kib_per_sec < 0 || kib_per_sec > MIRROR_MAX_RATE)
+		return CMD_FAILURE;
+	m_mirror_rate = kib_per_sec;
+	m_mirror_allowance = 0;
+	XTime_GetTime(&m_mirror_last_service);
+
+	return CMD_SUCCESS;
+}
+
+/*
+ * Getter function for the mirror rate.
+ *
+ * @param	None
+ *
+ * @return	(int) KiB per second, 0 if the mirror is off
+ */
+int MirrorGetRate( void )
+{
+	return m_mirror_rate;
+}
+
+/*
+ * Add a finished folder on SD card 0 to the mirror queue. The files in it are counted up
+ *  here so that the status command can report how far behind the mirror is.
+ * Only call this once everything in the folder has been closed.
+ *
+ * @param	(char *) the folder, "0:/..."
+ *
+ * @return	(int) CMD_SUCCESS/CMD_FAILURE if the queue is full or the folder can't be read
+ */
+int MirrorQueueFolder( char * folder )
+{
+	unsigned int folder_bytes = 0;
+	DIR dir;
+	FILINFO fno;
+	TCHAR LFName[256];
+	fno.lfname = LFName;
+	fno.lfsize = sizeof(LFName);
+	FRESULT f_res = FR_OK;
+
+	if(folder == NULL || strncmp(folder, "0:", 2) != 0 || strlen(folder) >= MIRROR_PATH_SIZE)
+		return CMD_FAILURE;
+	if(m_mirror_count >= MIRROR_QUEUE_DEPTH)
+	{
+		m_mirror_errors++;
+		xil_printf("1 mirror queue full\n");
+		return CMD_FAILURE;
+	}
+
+	f_res = f_opendir(&dir, folder);
+	if(f_res != FR_OK)
+		return CMD_FAILURE;
+	while(1)
+	{
+		f_res = f_readdir(&dir, &fno);
+		if(f_res != FR_OK || fno.fname[0] == 0)
+			break;
+		if(!(fno.fattrib & AM_DIR))
+			folder_bytes += fno.fsize;
+	}
+	f_closedir(&dir);
+
+	strcpy(m_mirror_queue[m_mirror_head], folder);
+	XTime_GetTime(&m_mirror_queue_time[m_mirror_head]);
+	m_mirror_queue_bytes[m_mirror_head] = folder_bytes;
+	m_mirror_head = (m_mirror_head + 1) % MIRROR_QUEUE_DEPTH;
+	m_mirror_count++;
+	m_mirror_bytes_waiting += folder_bytes;
+
+	return CMD_SUCCESS;
+}
+
+/*
+ * Drop the oldest folder from the queue, whether or not it was copied completely.
+ */
+static void MirrorPopFolder( void )
+{
+	if(m_mirror_dir_open == 1)
+		f_closedir(&m_mirror_dir);
+	m_mirror_dir_open = 0;
+	if(m_mirror_bytes_waiting >= m_mirror_queue_bytes[m_mirror_tail])
+		m_mirror_bytes_waiting -= m_mirror_queue_bytes[m_mirror_tail];
+	else
+		m_mirror_bytes_waiting = 0;
+	m_mirror_queue_bytes[m_mirror_tail] = 0;
+	m_mirror_tail = (m_mirror_tail + 1) % MIRROR_QUEUE_DEPTH;
+	m_mirror_count--;
+
+	return;
+}
+
+/*
+ * Stop copying the current file and delete the partial copy on SD card 1, so that nothing is
+ *  left on card 1 which looks like a good copy but isn't.
+ *
+ * @param	(int) 1 to copy the file again from the start later (the bytes already copied are
+ * 				put back into the counts), 0 to give up on the file and count an error
+ */
+static void MirrorAbortFile( int retry )
+{
+	if(m_mirror_file_open == 0)
+		return;
+	f_close(&m_mirror_src);
+	f_close(&m_mirror_dst);
+	f_unlink(m_mirror_dst_name);
+	m_mirror_file_open = 0;
+	if(retry == 1)
+	{
+		m_mirror_queue_bytes[m_mirror_tail] += m_mirror_file_bytes;
+		m_mirror_bytes_waiting += m_mirror_file_bytes;
+		m_mirror_retry = 1;
+	}
+	else
+		m_mirror_errors++;
+	m_mirror_file_bytes = 0;
+
+	return;
+}
+
+/*
+ * Close the copy in progress before an acquisition starts, so no file on either card is left
+ *  open while DAQ or WF runs. The partial copy is deleted and the file is copied again from the
+ *  start once MirrorService() is called again.
+ *
+ * @param	None
+ *
+ * @return	None
+ */
+void MirrorPause( void )
+{
+	MirrorAbortFile(1);
+	return;
+}
+
+/*
+ * Open the next file of the oldest folder for copying, creating the folder on SD card 1 first
+ *  if this is the start of the folder. When the folder has no files left it is taken off the queue.
+ */
+static void MirrorOpenNextFile( void )
+{
+	char * folder = m_mirror_queue[m_mirror_tail];
+	char * name = NULL;
+	char dst_name[MIRROR_PATH_SIZE + 260] = "";
+	FILINFO fno;
+	TCHAR LFName[256];
+	fno.lfname = LFName;
+	fno.lfsize = sizeof(LFName);
+	FRESULT f_res = FR_OK;
+
+	if(m_mirror_dir_open == 0)
+	{
+		//same folder name, on SD card 1
+		snprintf(dst_name, sizeof(dst_name), "1%s", folder + 1);
+		f_res = f_mkdir(dst_name);
+		if(f_res == FR_OK || f_res == FR_EXIST)
+			f_res = f_opendir(&m_mirror_dir, folder);
+		if(f_res != FR_OK)
+		{
+			m_mirror_errors++;
+			MirrorPopFolder();
+			return;
+		}
+		m_mirror_dir_open = 1;
+	}
+
+	if(m_mirror_retry == 0)
+	{
+		f_res = f_readdir(&m_mirror_dir, &fno);
+		if(f_res != FR_OK || fno.fname[0] == 0)
+		{
+			MirrorPopFolder();	//done with this folder
+			return;
+		}
+		if(fno.fattrib & AM_DIR)
+			return;
+#if _USE_LFN
+		name = *fno.lfname ? fno.lfname : fno.fname;
+#else
+		name = fno.fname;
+#endif
+		snprintf(m_mirror_src_name, sizeof(m_mirror_src_name), "%s/%s", folder, name);
+		snprintf(m_mirror_dst_name, sizeof(m_mirror_dst_name), "1%s/%s", folder + 1, name);
+	}
+	m_mirror_retry = 0;	//the names are still set from the copy which was stopped
+
+	m_mirror_file_bytes = 0;
+	f_res = f_open(&m_mirror_src, m_mirror_src_name, FA_READ);
+	if(f_res != FR_OK)
+	{
+		m_mirror_errors++;
+		return;
+	}
+	f_res = f_open(&m_mirror_dst, m_mirror_dst_name, FA_CREATE_ALWAYS | FA_WRITE);
+	if(f_res != FR_OK)
+	{
+		f_close(&m_mirror_src);
+		m_mirror_errors++;
+		return;
+	}
+	m_mirror_file_open = 1;
+
+	return;
+}
+
+/*
+ * Copy the next chunk of the mirror. Call this from the idle loop only.
+ * Each call does at most one small piece of work (open a file or copy MIRROR_CHUNK_SIZE bytes),
+ *  and only once enough time has passed for the set rate to allow it. This keeps each call short
+ *  enough that polling for commands and SOH are not held up.
+ *
+ * @param	None
+ *
+ * @return	None
+ */
+void MirrorService( void )
+{
+	unsigned int bytes_read = 0;
+	unsigned int bytes_written = 0;
+	XTime current_time = 0;
+	XTime elapsed = 0;
+	FRESULT f_res = FR_OK;
+
+	XTime_GetTime(&current_time);
+	elapsed = current_time - m_mirror_last_service;
+	m_mirror_last_service = current_time;
+	if(m_mirror_rate == 0 || m_mirror_count == 0)
+	{
+		m_mirror_allowance = 0;
+		return;
+	}
+
+	//earn bytes at the set rate, never bank more than one chunk
+	if(elapsed > COUNTS_PER_SECOND)
+		elapsed = COUNTS_PER_SECOND;
+	m_mirror_allowance += (unsigned int)((elapsed * (XTime)m_mirror_rate * 1024) / COUNTS_PER_SECOND);
+	if(m_mirror_allowance > MIRROR_CHUNK_SIZE)
+		m_mirror_allowance = MIRROR_CHUNK_SIZE;
+	if(m_mirror_allowance < MIRROR_CHUNK_SIZE)
+		return;
+
+	if(m_mirror_file_open == 0)
+	{
+		MirrorOpenNextFile();
+		return;
+	}
+
+	f_res = f_read(&m_mirror_src, m_mirror_buff, MIRROR_CHUNK_SIZE, &bytes_read);
+	if(f_res == FR_OK && bytes_read > 0)
+		f_res = f_write(&m_mirror_dst, m_mirror_buff, bytes_read, &bytes_written);
+	m_mirror_allowance -= MIRROR_CHUNK_SIZE;
+	if(f_res != FR_OK || bytes_written != bytes_read)
+	{
+		//give up on this file, don't leave a partial copy behind
+		MirrorAbortFile(0);
+		return;
+	}
+	if(m_mirror_queue_bytes[m_mirror_tail] >= bytes_written)
+	{
+		m_mirror_queue_bytes[m_mirror_tail] -= bytes_written;
+		m_mirror_bytes_waiting -= bytes_written;
+		m_mirror_file_bytes += bytes_written;
+	}
+
+	if(bytes_read < MIRROR_CHUNK_SIZE)
+	{
+		//end of the file, it only counts as a good copy if it closes cleanly
+		f_close(&m_mirror_src);
+		m_mirror_file_open = 0;
+		m_mirror_file_bytes = 0;
+		if(f_close(&m_mirror_dst) != FR_OK)
+		{
+			f_unlink(m_mirror_dst_name);
+			m_mirror_errors++;
+		}
+	}
+
+	return;
+}
+
+/*
+ * Getter function for the number of folders which are waiting for, or in the middle of, a copy.
+ *
+ * @param	None
+ *
+ * @return	(unsigned int) the number of folders in the mirror queue
+ */
+unsigned int MirrorGetFoldersWaiting( void )
+{
+	return (unsigned int)m_mirror_count;
+}
+
+/*
+ * Getter function for the number of bytes which are on SD card 0 but not yet on SD card 1.
+ *
+ * @param	None
+ *
+ * @return	(unsigned int) the bytes left to copy
+ */
+unsigned int MirrorGetBytesWaiting( void )
+{
+	return m_mirror_bytes_waiting;
+}
+
+/*
+ * Getter function for how far behind the mirror is, the age of the oldest folder in the queue.
+ *
+ * @param	None
+ *
+ * @return	(unsigned int) seconds since the oldest waiting folder was queued, 0 if none are waiting
+ */
+unsigned int MirrorGetLagSeconds( void )
+{
+	XTime current_time = 0;
+
+	if(m_mirror_count == 0)
+		return 0;
+	XTime_GetTime(&current_time);
+
+	return (unsigned int)((current_time - m_mirror_queue_time[m_mirror_tail]) / COUNTS_PER_SECOND);
+}
+
+/*
+ * Getter function for the number of folders and files which could not be mirrored.
+ *
+ * @param	None
+ *
+ * @return	(unsigned int) the mirror error count since power on
+ */
+unsigned int MirrorGetErrors( void )
+{
+	return m_mirror_errors;
+}
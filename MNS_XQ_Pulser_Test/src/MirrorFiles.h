@@ -0,0 +1,37 @@
+/*
+ * MirrorFiles.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ *
+ * Copies finished data product folders from SD card 0 to SD card 1 in the background.
+ * A folder is queued once its run (DAQ or WF) is closed out, then MirrorService() copies it a
+ *  chunk at a time from the idle loop in main, limited to a set number of bytes per second.
+ * Nothing in here runs during a DAQ or WF run, so the mirror never adds latency to acquisition.
+ *  MirrorPause() closes the copy in progress when a run starts, so no mirror files are left open.
+ * A file which could not be copied is deleted from SD card 1 and counted in MirrorGetErrors(),
+ *  so every file on card 1 is a complete copy.
+ */
+
+#ifndef SRC_MIRRORFILES_H_
+#define SRC_MIRRORFILES_H_
+
+#include <stdio.h>
+#include <string.h>
+#include "xil_printf.h"
+#include "xtime_l.h"
+#include "ff.h"
+#include "lunah_defines.h"
+
+// prototypes
+int MirrorSetRate( int kib_per_sec );
+int MirrorGetRate( void );
+int MirrorQueueFolder( char * folder );
+void MirrorService( void );
+void MirrorPause( void );
+unsigned int MirrorGetFoldersWaiting( void );
+unsigned int MirrorGetBytesWaiting( void );
+unsigned int MirrorGetLagSeconds( void );
+unsigned int MirrorGetErrors( void );
+
+#endif /* SRC_MIRRORFILES_H_ */
@@ -209,6 +209,44 @@ int ReadCommandType(char * RecvBuffer, XUartPs *Uart_PS) {
 						commandNum = DAQ_CMD;
 
 				}
+				else if(!strcmp(commandBuffer, "DAQCFG"))
+				{
+					//option number, then the value to set it to
+					ret = sscanf(RecvBuffer + strlen(commandMNSBuf) + strlen(commandBuffer) + 2, " %d_%d_%d", &detectorVal, &firstVal, &secondVal);
+
+					if(ret != 3)	//invalid input
+						commandNum = -1;
+					else
+						commandNum = DAQCFG_CMD;
+				}
+				else if(!strcmp(commandBuffer, "MIRROR"))
+				{
+					//mirror rate in KiB per second, 0 turns the mirror off
+					ret = sscanf(RecvBuffer + strlen(commandMNSBuf) + strlen(commandBuffer) + 2, " %d_%d", &detectorVal, &firstVal);
+
+					if(ret != 2)	//invalid input
+						commandNum = -1;
+					else
+						commandNum = MIRROR_CMD;
+				}
+				else if(!strcmp(commandBuffer, "MIRRORSTAT"))
+				{
+					ret = sscanf(RecvBuffer + strlen(commandMNSBuf) + strlen(commandBuffer) + 2, " %d", &detectorVal);
+
+					if(ret != 1)	//invalid input
+						commandNum = -1;
+					else
+						commandNum = MIRRORSTAT_CMD;
+				}
+				else if(!strcmp(commandBuffer, "PROFILE"))
+				{
+					ret = sscanf(RecvBuffer + strlen(commandMNSBuf) + strlen(commandBuffer) + 2, " %d", &detectorVal);
+
+					if(ret != 1)	//invalid input
+						commandNum = -1;
+					else
+						commandNum = PROFILE_CMD;
+				}
 				else if(!strcmp(commandBuffer, "WF"))
 				{
 					ret = sscanf(RecvBuffer + strlen(commandMNSBuf) + strlen(commandBuffer) + 2, " %d_%d_%d_%d", &detectorVal, &firstVal, &secondVal, &thirdVal);
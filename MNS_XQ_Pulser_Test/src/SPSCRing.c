@@ -0,0 +1,182 @@
+/*
+ * SPSCRing.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ */
+
+#include "SPSCRing.h"
+
+/*
+ * Set up a ring over the storage provided by the caller. The ring holds num_slots records,
+ *  the storage must be at least slot_size * num_slots bytes. Only call this while neither side
+ *  is using the ring.
+ *
+ * @param	(SPSC_RING_TYPE *) the ring to initialize
+ * @param	(void *) the record storage
+ * @param	(unsigned int) the size of one record in bytes
+ * @param	(unsigned int) the number of records the storage holds
+ *
+ * @return	None
+ */
+void SPSCRingInit( SPSC_RING_TYPE * ring, void * storage, unsigned int slot_size, unsigned int num_slots )
+{
+	ring->slots = (unsigned char *)storage;
+	ring->slot_size = slot_size;
+	ring->num_slots = num_slots;
+	ring->high_water = 0;
+	ring->overflows = 0;
+	ring->head = 0;
+	ring->tail = 0;
+
+	return;
+}
+
+/*
+ * Copy a record into the ring. Producer side only.
+ *
+ * @param	(SPSC_RING_TYPE *) the ring
+ * @param	(const void *) the record to copy in, slot_size bytes
+ *
+ * @return	(int) CMD_SUCCESS, or CMD_FAILURE if the ring was full and the record was dropped
+ */
+int SPSCRingPush( SPSC_RING_TYPE * ring, const void * record )
+{
+	return SPSCRingPushBytes(ring, record, ring->slot_size);
+}
+
+/*
+ * Copy a record which may be shorter than a slot into the ring. Producer side only.
+ * Only the first bytes of the slot are written, the rest of the slot is left as it was. The
+ *  record has to say how long it is (in a header, say) so that the consumer knows how much
+ *  of the slot to use.
+ *
+ * @param	(SPSC_RING_TYPE *) the ring
+ * @param	(const void *) the record to copy in
+ * @param	(unsigned int) the size of the record in bytes, no more than slot_size
+ *
+ * @return	(int) CMD_SUCCESS, or CMD_FAILURE if the ring was full or the record too big and it was dropped
+ */
+int SPSCRingPushBytes( SPSC_RING_TYPE * ring, const void * record, unsigned int bytes )
+{
+	unsigned int head = ring->head;
+	unsigned int next = (head + 1 < ring->num_slots) ? head + 1 : 0;
+	unsigned int count = 0;
+
+	//one slot is always left open so that head == tail means empty
+	if(next == ring->tail)
+	{
+		ring->overflows++;
+		return CMD_FAILURE;
+	}
+
+	if(bytes > ring->slot_size)
+	{
+		ring->overflows++;
+		return CMD_FAILURE;
+	}
+
+	memcpy(&ring->slots[head * ring->slot_size], record, bytes);
+	ring->head = next;
+
+	count = SPSCRingCount(ring);
+	if(count > ring->high_water)
+		ring->high_water = count;
+
+	return CMD_SUCCESS;
+}
+
+/*
+ * Look at the oldest record in the ring without removing it. Consumer side only.
+ * The record stays valid until SPSCRingPop() is called.
+ *
+ * @param	(SPSC_RING_TYPE *) the ring
+ *
+ * @return	(void *) pointer to the oldest record, NULL if the ring is empty
+ */
+void * SPSCRingPeek( SPSC_RING_TYPE * ring )
+{
+	unsigned int tail = ring->tail;
+
+	if(tail == ring->head)
+		return NULL;
+
+	return &ring->slots[tail * ring->slot_size];
+}
+
+/*
+ * Remove the oldest record from the ring and hand its slot back to the producer.
+ * Consumer side only, call after SPSCRingPeek() returned a record.
+ *
+ * @param	(SPSC_RING_TYPE *) the ring
+ *
+ * @return	None
+ */
+void SPSCRingPop( SPSC_RING_TYPE * ring )
+{
+	unsigned int tail = ring->tail;
+
+	if(tail == ring->head)
+		return;
+	ring->tail = (tail + 1 < ring->num_slots) ? tail + 1 : 0;
+
+	return;
+}
+
+/*
+ * Getter function for the number of records waiting in the ring.
+ * Safe from either side.
+ *
+ * @param	(SPSC_RING_TYPE *) the ring
+ *
+ * @return	(unsigned int) the number of records waiting
+ */
+unsigned int SPSCRingCount( SPSC_RING_TYPE * ring )
+{
+	if(ring->head >= ring->tail)
+		return ring->head - ring->tail;
+	return ring->head + ring->num_slots - ring->tail;
+}
+
+/*
+ * Getter function for the number of waiting records which sit back-to-back in the storage,
+ *  starting with the oldest. These may be read as one block from the pointer SPSCRingPeek()
+ *  returns and then popped one at a time. Consumer side only.
+ *
+ * @param	(SPSC_RING_TYPE *) the ring
+ *
+ * @return	(unsigned int) the number of records from the oldest up to the end of the storage or the newest
+ */
+unsigned int SPSCRingCountContiguous( SPSC_RING_TYPE * ring )
+{
+	unsigned int head = ring->head;
+	unsigned int tail = ring->tail;
+
+	if(head >= tail)
+		return head - tail;
+	return ring->num_slots - tail;
+}
+
+/*
+ * Getter function for the most records which have ever been waiting in the ring at once.
+ *
+ * @param	(SPSC_RING_TYPE *) the ring
+ *
+ * @return	(unsigned int) the high-water mark since SPSCRingInit()
+ */
+unsigned int SPSCRingGetHighWater( SPSC_RING_TYPE * ring )
+{
+	return ring->high_water;
+}
+
+/*
+ * Getter function for the number of records which were dropped because the ring was full.
+ *
+ * @param	(SPSC_RING_TYPE *) the ring
+ *
+ * @return	(unsigned int) the number of refused pushes since SPSCRingInit()
+ */
+unsigned int SPSCRingGetOverflows( SPSC_RING_TYPE * ring )
+{
+	return ring->overflows;
+}
@@ -0,0 +1,43 @@
+/*
+ * SPSCRing.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: IRDLab
+ *
+ * A single-producer/single-consumer ring of fixed size records. This is the hand-off between
+ *  the processing stage (ProcessData, CPS tallies, 2DH tallies) and the I/O stage (FatFs writes).
+ * Exactly one stage may push and exactly one stage may peek/pop. Both stages run in the DAQ loop
+ *  on core 0 and never interrupt each other, so the ring needs no barriers, locks, or interrupt
+ *  masking. Do not use it between the loop and an interrupt handler, or between cores, without
+ *  adding them back.
+ */
+
+#ifndef SRC_SPSCRING_H_
+#define SRC_SPSCRING_H_
+
+#include <string.h>
+#include "xil_types.h"
+#include "lunah_defines.h"
+
+typedef struct {
+	unsigned int head;							//next slot the producer fills, written by the producer only
+	unsigned int tail;							//next slot the consumer reads, written by the consumer only
+	unsigned char * slots;						//storage for num_slots records of slot_size bytes
+	unsigned int slot_size;
+	unsigned int num_slots;
+	unsigned int high_water;					//most records ever waiting in the ring, producer side
+	unsigned int overflows;						//pushes refused because the ring was full, producer side
+}SPSC_RING_TYPE;
+
+// prototypes
+void SPSCRingInit( SPSC_RING_TYPE * ring, void * storage, unsigned int slot_size, unsigned int num_slots );
+int SPSCRingPush( SPSC_RING_TYPE * ring, const void * record );
+int SPSCRingPushBytes( SPSC_RING_TYPE * ring, const void * record, unsigned int bytes );
+void * SPSCRingPeek( SPSC_RING_TYPE * ring );
+void SPSCRingPop( SPSC_RING_TYPE * ring );
+unsigned int SPSCRingCount( SPSC_RING_TYPE * ring );
+unsigned int SPSCRingCountContiguous( SPSC_RING_TYPE * ring );
+unsigned int SPSCRingGetHighWater( SPSC_RING_TYPE * ring );
+unsigned int SPSCRingGetOverflows( SPSC_RING_TYPE * ring );
+
+#endif /* SRC_SPSCRING_H_ */
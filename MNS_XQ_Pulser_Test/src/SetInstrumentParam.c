@@ -574,6 +574,7 @@ int SetIntegrationTime(int Baseline, int Short, int Long, int Full)
 							m_short_integration_samples = (INTEG_TIME_START + Short) / NS_TO_SAMPLES + 1;
 							m_long_integration_samples = (INTEG_TIME_START + Long) / NS_TO_SAMPLES + 1;
 							m_full_integration_samples = (INTEG_TIME_START + Full) / NS_TO_SAMPLES + 1;
+							BinningUpdate(m_baseline_integration_samples, m_short_integration_samples, m_long_integration_samples, m_full_integration_samples);
 							status = CMD_SUCCESS;
 						}
 						else
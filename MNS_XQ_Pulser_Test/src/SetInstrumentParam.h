@@ -19,6 +19,7 @@
 #include "lunah_utils.h"
 #include "LI2C_Interface.h"
 #include "RecordFiles.h"
+#include "EventBinning.h"
 
 /*
  * Mini-NS Configuration Parameter Structure
@@ -70,13 +71,34 @@ typedef struct {
 * 		Thus, for file type CPS, we put a 5 as that char, which corresponds
 * 		 to APID_MNS_CPS and DATA_TYPE_CPS
 *
-* Size = 320 bytes (10/23/19)
+* The EVT batching values describe the layout of the EVT files for ground tools:
+*  each EVT block holds up to EVTBatchBuffers * 512 events, and the file was
+*  synced every EVTSyncBlocks blocks. EVTFormat says how the blocks are written,
+*  EVT_FORMAT_STANDARD or EVT_FORMAT_COMPACT, and EVTCompression says whether each
+*  block was then compressed, EVT_COMPRESS_OFF or EVT_COMPRESS_ON. EVTFilter says
+*  which data events were kept, EVT_FILTER_#, with the energy and PSD bins kept for
+*  EVT_FILTER_REGION. They are recorded in every file of the run.
+*
+* EVTDataEnd is the byte offset of the end of the good data in an EVT set file, it is
+*  0 in the other files. EVT set files are preallocated, so the size in the directory
+*  entry covers the whole SIZE_10_MIB + margin from the time the file is opened and
+*  only shrinks to the data when the file is closed (see PreallocateEVTFile()). The
+*  flight software rewrites EVTDataEnd before each sync of the file. If the file
+*  was never closed (power loss or reset during a run), the file size is larger than
+*  EVTDataEnd and everything past EVTDataEnd is stale card contents, not EVT data.
+*  Ground tools must stop reading at EVTDataEnd, the blocks written after the last
+*  sync are lost either way.
+*
+* Size = 352 bytes (10/17/26)
 * 4 padding bytes (10/23/19)
 * Outline:
 * 	config buff = 300 bytes
 * 	padding bytes = 4 bytes
 * 	4 x 3 = 12 bytes
 * 	1 x 4 = 4 bytes
+* 	4 x 5 = 20 bytes
+* 	2 x 4 = 8 bytes
+* 	4 x 1 = 4 bytes
 *
 */
 typedef struct{
@@ -88,6 +110,16 @@ typedef struct{
 	unsigned char TempCorrectionSetNum;
 	unsigned char EventID1;
 	unsigned char EventID2;
+	unsigned int EVTBatchBuffers;
+	unsigned int EVTSyncBlocks;
+	unsigned int EVTFormat;
+	unsigned int EVTCompression;
+	unsigned int EVTFilter;
+	unsigned short EVTFilterEnergyMin;
+	unsigned short EVTFilterEnergyMax;
+	unsigned short EVTFilterPSDMin;
+	unsigned short EVTFilterPSDMax;
+	unsigned int EVTDataEnd;
 }DATA_FILE_HEADER_TYPE;
 
 /*
@@ -110,8 +142,19 @@ typedef struct{
 
 /*
  * Footer for EVT, CPS data products
+ * The run accounting (buffers, dead time, CPU time per stage) is filled in by UpdateFooterStatistics()
+ *  and covers the run from its start up to when the footer was written.
+ *
+ * The stage profile summary gives the mean and worst pass of the DAQ loop and the worst pass of
+ *  the ProcessData and SD card drain stages, the full profile is dumped with MNS_PROFILE.
+ *
+ * The event quality counters are what ProcessData() rejected or flagged, see EVENT_QUALITY_TYPE. With
+ *  them are the number of buffers ProcessData() had to resynchronize in and the most words it skipped in one.
+ *
+ * The queue counters give the most entries waiting at once and the entries lost to a full queue for
+ *  the EVT write-behind, CPS record, and raw buffer queues, see SPSCRingGetHighWater().
  *
- * Size = 20 bytes (10/23/19)
+ * Size = 144 bytes (10/17/26)
  */
 typedef struct{
 	unsigned char eventID1;
@@ -124,6 +167,37 @@ typedef struct{
 	unsigned char eventID7;
 	unsigned char eventID8;
 	int digiTemp;
+	unsigned int BuffersProcessed;
+	unsigned int BuffersDropped;
+	unsigned int BuffersOverrun;
+	unsigned int DMATimeouts;
+	unsigned int MaxLatencyUs;
+	unsigned int DeadTimeMs;
+	unsigned int ProcessTimeMs;
+	unsigned int DrainTimeMs;
+	unsigned int SOHTimeMs;
+	unsigned int LoopMeanUs;
+	unsigned int LoopMaxUs;
+	unsigned int ProcessMaxUs;
+	unsigned int DrainMaxUs;
+	unsigned int RejectedTime;
+	unsigned int RejectedEventNumber;
+	unsigned int RejectedOrdering;
+	unsigned int BadPSD;
+	unsigned int MultiHit;
+	unsigned int EnergyOutOfRange;
+	unsigned int JunkWords;
+	unsigned int BuffersResynced;
+	unsigned int MaxWordsSkipped;
+	unsigned int PulserEvents;
+	unsigned int FalseEvents;
+	unsigned int FilteredEvents;
+	unsigned int EVTQueueHighWater;
+	unsigned int EVTQueueOverflows;
+	unsigned int CPSQueueHighWater;
+	unsigned int CPSQueueOverflows;
+	unsigned int RawQueueHighWater;
+	unsigned int RawQueueOverflows;
 	unsigned char eventID9;
 	unsigned char eventID10;
 	unsigned char eventID11;
@@ -138,35 +138,30 @@ int Tally2DH(int energy_bin, int psd_bin, int pmt_ID)
 	int status = 0;
 	int m_valid_multi_hit_event = 0;
 
-	if(0 <= energy_bin && energy_bin < TWODH_X_BINS)
+	if(BinningIsInRange(energy_bin, psd_bin) == TRUE)
 	{
-		if(0 <= psd_bin && psd_bin < TWODH_Y_BINS)
+		//value is good
+		status = 1;
+		switch(pmt_ID)
 		{
-			//value is good
-			status = 1;
-			switch(pmt_ID)
-			{
-			case PMT_ID_0:
-				m_2DH_pmt0[energy_bin][psd_bin]++;
-				break;
-			case PMT_ID_1:
-				m_2DH_pmt1[energy_bin][psd_bin]++;
-				break;
-			case PMT_ID_2:
-				m_2DH_pmt2[energy_bin][psd_bin]++;
-				break;
-			case PMT_ID_3:
-				m_2DH_pmt3[energy_bin][psd_bin]++;
-				break;
-			default:
-				//don't record non-singleton hits in a 2DH
-				m_valid_multi_hit_event++;
-				status = -1;
-				break;
-			}
+		case PMT_ID_0:
+			m_2DH_pmt0[energy_bin][psd_bin]++;
+			break;
+		case PMT_ID_1:
+			m_2DH_pmt1[energy_bin][psd_bin]++;
+			break;
+		case PMT_ID_2:
+			m_2DH_pmt2[energy_bin][psd_bin]++;
+			break;
+		case PMT_ID_3:
+			m_2DH_pmt3[energy_bin][psd_bin]++;
+			break;
+		default:
+			//don't record non-singleton hits in a 2DH
+			m_valid_multi_hit_event++;
+			status = -1;
+			break;
 		}
-		else
-			status = 0;
 	}
 	else
 		status = 0;
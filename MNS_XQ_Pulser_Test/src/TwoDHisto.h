@@ -14,6 +14,7 @@
 #include "lunah_defines.h"
 #include "DataAcquisition.h"
 #include "RecordFiles.h"
+#include "EventBinning.h"
 
 //function prototypes
 int Save2DHToSD( int pmt_ID );
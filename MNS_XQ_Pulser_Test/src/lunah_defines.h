@@ -12,8 +12,6 @@
 
 #define MNS_DETECTOR_NUM	1
 
-#define PRODUCE_RAW_DATA	0
-
 #define NS_TO_SAMPLES		4		//conversion factor number of nanoseconds per sample
 #define INTEG_TIME_START	200
 #define LOG_FILE_BUFF_SIZE	120
@@ -31,13 +29,17 @@
 #define TELEMETRY_MAX_SIZE	2038
 #define VALID_BUFFER_SIZE	512
 #define DATA_BUFFER_SIZE	4096
-#define EVENT_BUFFER_SIZE	2048
-#define EVT_DATA_BUFF_SIZE	16384
+#define EVT_MAX_BATCH_BUFFERS	16	//the most FPGA buffers of events collected into one EVT block
+#define EVENT_BUFFER_SIZE	(EVT_MAX_BATCH_BUFFERS * VALID_BUFFER_SIZE)	//events held for the largest EVT block //8192
+#define EVT_DATA_BUFF_SIZE	16384	//size of the EVT file headers after padding to the cluster edge
 #define SIZEOF_HEADER_TIMES	14
 #define TWODH_X_BINS		512		//260
 #define	TWODH_Y_BINS		64		//30
 #define TWODH_ENERGY_MAX	1200000	//previously used 1,000,000 but recalculated that this was correct using temp. calib. data
 #define TWODH_PSD_MAX		2.0
+//event binning integer path, see EVENT_BINNING_TYPE
+#define FIXED_POINT_MAX_SAMPLES	8192	//largest integration, in samples, the 64-bit integer path can handle
+#define FIXED_BIN_UNSAFE		-999	//the event sits too close to a bin edge to trust the integer bin
 #define RMD_CHECKSUM_SIZE	2
 #define SYNC_MARKER			892270675	//0x35 2E F8 53
 #define SYNC_MARKER_SIZE	4
@@ -50,6 +52,8 @@
 #define SIZE_1_MIB			1048576	//1 MiB, rather than 1 MB (1e6 bytes)
 #define SIZE_10_MIB			10485760	//10 MiB
 #define DP_HEADER_SIZE		16384	//we put blank space past the header so we always write on a cluster boundary
+#define EVT_PREOPEN_MARGIN	SIZE_1_MIB	//the next EVT set file is prepared once the current one is this close to rolling over
+#define EVT_PREALLOC_SIZE	(SIZE_10_MIB + 2 * EVENT_BUFFER_SIZE * EVT_EVENT_SIZE)	//EVT files are allocated up front, room for the last block and footer past 10 MiB
 #define XB1_SEND_WAIT		0.015	//15ms wait time; this accounts for the latency on the XB-1 side of communications
 
 //PMT ID Values
@@ -80,6 +84,10 @@
 #define BREAK_CMD		16
 #define START_CMD		17
 #define END_CMD			18
+#define DAQCFG_CMD		19
+#define MIRROR_CMD		20
+#define MIRRORSTAT_CMD	21
+#define PROFILE_CMD		22
 #define INPUT_OVERFLOW	100
 
 //Command SUCCESS/FAILURE values
@@ -157,6 +165,86 @@
 //MNS DATA FILE FOOTER SIZES //The main data products have a footer in the file
 #define FILE_FOOT_2DH	20
 
+//DAQ RUN OPTIONS //set with MNS_DAQCFG_<det>_<option>_<value>
+#define DAQ_OPT_RING_DEPTH	0
+#define DAQ_OPT_RAW_MODE	1
+#define DAQ_OPT_RAW_PARAM	2
+#define DAQ_OPT_EVT_BATCH	3
+#define DAQ_OPT_EVT_SYNC	4
+#define DAQ_OPT_CPS_FLUSH_RECORDS	5
+#define DAQ_OPT_CPS_FLUSH_SECONDS	6
+#define DAQ_OPT_PULSER_RATE	7
+#define DAQ_OPT_EVT_FORMAT	8
+#define DAQ_OPT_EVT_COMPRESS	9
+#define DAQ_OPT_EVT_FILTER	10
+#define DAQ_OPT_FILTER_ENERGY_MIN	11
+#define DAQ_OPT_FILTER_ENERGY_MAX	12
+#define DAQ_OPT_FILTER_PSD_MIN	13
+#define DAQ_OPT_FILTER_PSD_MAX	14
+#define DAQ_OPT_DCACHE		15
+#define DAQ_NUM_OPTIONS		16
+
+//DAQ RAW CAPTURE MODES //DAQ_OPT_RAW_MODE
+#define RAW_MODE_OFF		0		//no raw data is saved
+#define RAW_MODE_FULL		1		//every buffer is saved
+#define RAW_MODE_FIRST_N	2		//buffers from the first DAQ_OPT_RAW_PARAM seconds of the run are saved
+#define RAW_MODE_DECIMATED	3		//one of every DAQ_OPT_RAW_PARAM buffers is saved
+#define RAW_DEFAULT_PARAM	10
+#define RAW_QUEUE_DEPTH		8		//raw buffers waiting for the SD card
+#define RAW_BATCH_BUFFERS	4		//raw buffers written with each f_write
+#define RAW_SYNC_BATCHES	4		//raw batches written between each f_sync
+
+//DAQ EVT BATCHING //DAQ_OPT_EVT_BATCH, DAQ_OPT_EVT_SYNC
+#define EVT_DEFAULT_BATCH_BUFFERS	4	//FPGA buffers per EVT block, 1 -> EVT_MAX_BATCH_BUFFERS
+#define EVT_DEFAULT_SYNC_BLOCKS		4	//EVT blocks written between each f_sync, 1 -> EVT_MAX_SYNC_BLOCKS
+#define EVT_MAX_SYNC_BLOCKS			64
+
+//DAQ EVT FORMAT //DAQ_OPT_EVT_FORMAT, recorded in the file headers as EVTFormat
+#define EVT_FORMAT_STANDARD		1	//8 byte events in blocks behind an EVT_BLOCK_HEADER_TYPE
+#define EVT_FORMAT_COMPACT		2	//delta time records behind an EVT_COMPACT_HEADER_TYPE, see EVTCompact.h
+#define EVT_COMPACT_SYNC_EVENTS	256	//data events between absolute time sync records in the compact format
+
+//DAQ EVT COMPRESSION //DAQ_OPT_EVT_COMPRESS, recorded in the file headers as EVTCompression
+#define EVT_COMPRESS_OFF		0	//EVT blocks are written as they are
+#define EVT_COMPRESS_ON			1	//each EVT block is compressed behind an EVT_COMPRESS_HEADER_TYPE, see EVTCompress.h
+
+//DAQ EVT FILTER //DAQ_OPT_EVT_FILTER, DAQ_OPT_FILTER_#, recorded in the file headers as EVTFilter
+//data events which fail the filter are still tallied for CPS and the 2DH, they are just not put in the EVT file
+//pulser and false events are always kept
+#define EVT_FILTER_ALL			0	//every data event is kept
+#define EVT_FILTER_NEUTRONS		1	//only events inside one of the neutron ellipse cuts (the tagging bit is set)
+#define EVT_FILTER_REGION		2	//only events with energy and PSD bins inside the DAQ_OPT_FILTER_# region, inclusive
+
+//DAQ DATA CACHE //DAQ_OPT_DCACHE
+//the L1/L2 data caches are off outside of DAQ, a run may turn them on for its duration
+//compare MNS_PROFILE after a run with each setting to measure the ProcessData speedup
+#define DCACHE_OFF				0
+#define DCACHE_ON				1
+
+//DAQ CPS FLUSH POLICY //DAQ_OPT_CPS_FLUSH_RECORDS, DAQ_OPT_CPS_FLUSH_SECONDS
+//CPS records are held in RAM and written when either limit is hit, END/BREAK/time out always flush
+//worst case loss on a power failure is the lesser of the two limits (one record per second) plus the interval being counted,
+// a full record queue is always written out rather than dropped, see CPS_RECORD_QUEUE_DEPTH
+#define CPS_DEFAULT_FLUSH_RECORDS	10
+#define CPS_DEFAULT_FLUSH_SECONDS	10
+#define CPS_MAX_FLUSH_RECORDS		(CPS_RECORD_QUEUE_DEPTH / 2)	//the DAQ loop forces a drain when the queue is half full
+#define CPS_MAX_FLUSH_SECONDS		60
+
+//DAQ PULSER LIVE TIME //DAQ_OPT_PULSER_RATE
+//pulser events (0x4001B207) are counted in each CPS interval against the rate they are injected at
+#define PULSER_DEFAULT_RATE		0		//pulses per second, 0 = no pulser, live time is not measured
+#define PULSER_MAX_RATE			10000	//pulses per second
+#define CPS_LIVE_TIME_UNKNOWN	0xFFFFFFFF	//live time and dead fraction when there is no pulser rate
+#define CPS_DEAD_FRACTION_SCALE	10000	//dead fraction is reported in 0.01% units, 10000 = all dead
+
+//SD CARD MIRROR //MNS_MIRROR sets the rate, 0 turns the mirror off
+//finished run folders are copied from SD card 0 to SD card 1 from the idle loop, never during a run
+#define MIRROR_DEFAULT_RATE		256		//KiB per second
+#define MIRROR_MAX_RATE			4096	//KiB per second
+#define MIRROR_CHUNK_SIZE		4096	//bytes copied per call to MirrorService()
+#define MIRROR_QUEUE_DEPTH		16		//run folders waiting to be copied
+#define MIRROR_PATH_SIZE		100
+
 //DAQ FINAL STATE
 #define DAQ_BREAK		0
 #define DAQ_TIME_OUT	1
@@ -165,6 +253,15 @@
 //Mini-NS DMA Addresses to read from
 #define DRAM_BASE		0xA000000u
 #define DRAM_CEILING	0xA004000u
+//DAQ runs its DMA transfers through a ring of landing zones, starting at DRAM_BASE
+#define DMA_DEFAULT_RING_DEPTH	4
+#define DMA_MAX_RING_DEPTH		16
+#define DMA_LANDING_ZONE_STRIDE	0x10000u	//each zone can hold a full DMA_TRANSFER_SIZE transfer
+//CPS records finished by ProcessData() wait here until the DAQ loop writes them, one record per second
+//if a gap in the event times fills the queue inside one buffer, ProcessData() flushes it itself, no record is dropped
+#define CPS_RECORD_QUEUE_DEPTH	64
+//finished 16 KiB EVT blocks wait here until the drain stage writes them to the SD card
+#define EVT_WRITE_QUEUE_DEPTH	8
 
 //DAQ Neutron Counting
 #define NEUTRON_FOUND	1
@@ -289,6 +289,8 @@ int report_SOH(XIicPs * Iic, XTime local_time, XUartPs Uart_PS, int packet_type)
 	int b = 0;
 	int status = 0;
 	int bytes_sent = 0;
+	unsigned int daq_stat_value = 0;
+	EVENT_QUALITY_TYPE * evt_quality = GetEventQuality();
 
 	switch(check_temp_sensor){
 	case 0:	//analog board
@@ -399,6 +401,32 @@ int report_SOH(XIicPs * Iic, XTime local_time, XUartPs Uart_PS, int packet_type)
 		report_buff[91] = mode_byte;
 		memcpy(&report_buff[92], &soh_id_number, sizeof(int));
 		memcpy(&report_buff[96], &soh_run_number, sizeof(int));
+		//DAQ accounting for the current or most recent run
+		daq_stat_value = DAQStatsGetBuffersProcessed();
+		memcpy(&report_buff[100], &daq_stat_value, sizeof(unsigned int));
+		daq_stat_value = DAQStatsGetBuffersDropped();
+		memcpy(&report_buff[104], &daq_stat_value, sizeof(unsigned int));
+		daq_stat_value = DAQStatsGetBuffersOverrun();
+		memcpy(&report_buff[108], &daq_stat_value, sizeof(unsigned int));
+		daq_stat_value = DAQStatsGetMaxLatencyUs();
+		memcpy(&report_buff[112], &daq_stat_value, sizeof(unsigned int));
+		daq_stat_value = DAQStatsGetDeadTimeMs();
+		memcpy(&report_buff[116], &daq_stat_value, sizeof(unsigned int));
+		//event quality for the current or most recent run
+		memcpy(&report_buff[120], &evt_quality->rejected_time, sizeof(unsigned int));
+		memcpy(&report_buff[124], &evt_quality->rejected_event_number, sizeof(unsigned int));
+		memcpy(&report_buff[128], &evt_quality->rejected_ordering, sizeof(unsigned int));
+		memcpy(&report_buff[132], &evt_quality->bad_psd, sizeof(unsigned int));
+		memcpy(&report_buff[136], &evt_quality->multi_hit, sizeof(unsigned int));
+		memcpy(&report_buff[140], &evt_quality->energy_out_of_range, sizeof(unsigned int));
+		memcpy(&report_buff[144], &evt_quality->junk_words, sizeof(unsigned int));
+		memcpy(&report_buff[148], &evt_quality->pulser_events, sizeof(unsigned int));
+		memcpy(&report_buff[152], &evt_quality->false_events, sizeof(unsigned int));
+		//pulser live time for the most recent CPS interval
+		daq_stat_value = CPSGetLiveTime();
+		memcpy(&report_buff[156], &daq_stat_value, sizeof(unsigned int));
+		daq_stat_value = CPSGetDeadFraction();
+		memcpy(&report_buff[160], &daq_stat_value, sizeof(unsigned int));
 
 		PutCCSDSHeader(report_buff, APID_SOH, GF_UNSEG_PACKET, 0, SOH_PACKET_LENGTH);
 		CalculateChecksums(report_buff);
@@ -629,6 +657,127 @@ int reportFailure(XUartPs Uart_PS)
 	return status;
 }
 
+/**
+ * Report the status of the SD card 1 mirror in a SUCCESS packet.
+ * The payload is the command followed by the mirror status:
+ * 	RATE_FOLDERS_BYTES_LAG_ERRORS
+ * 	rate in KiB/s (0 = off), folders waiting, bytes waiting, age of the oldest
+ * 	waiting folder in seconds, and the folders/files which failed to copy
+ *
+ * @param Uart_PS	Pointer to the instance of the UART which will
+ * 					transmit the packet to the spacecraft.
+ *
+ * @return	CMD_SUCCESS or CMD_FAILURE depending on if we sent out
+ * 			the correct number of bytes with the packet.
+ */
+int reportMirrorStatus(XUartPs Uart_PS)
+{
+	int status = 0;
+	int bytes_sent = 0;
+	int packet_size = 0;	//Don't record the size of the CCSDS header with this variable
+	int i_sprintf_ret = 0;
+	unsigned char cmdSuccess[CMD_BUFFER_SIZE] = "";
+
+	i_sprintf_ret = snprintf((char *)(&cmdSuccess[11]), CMD_BUFFER_SIZE - CCSDS_HEADER_FULL - CHECKSUM_SIZE, "%s\n", GetLastCommand());
+	if(i_sprintf_ret != (int)GetLastCommandSize())
+		return CMD_FAILURE;
+	packet_size += i_sprintf_ret;
+	i_sprintf_ret = snprintf((char *)(&cmdSuccess[11 + packet_size]), CMD_BUFFER_SIZE - CCSDS_HEADER_FULL - CHECKSUM_SIZE - packet_size, "%d_%u_%u_%u_%u\n",
+			MirrorGetRate(), MirrorGetFoldersWaiting(), MirrorGetBytesWaiting(), MirrorGetLagSeconds(), MirrorGetErrors());
+	if(i_sprintf_ret <= 0 || i_sprintf_ret >= CMD_BUFFER_SIZE - CCSDS_HEADER_FULL - CHECKSUM_SIZE - packet_size)
+		return CMD_FAILURE;
+	packet_size += i_sprintf_ret;
+
+	PutCCSDSHeader(cmdSuccess, APID_CMD_SUCC, GF_UNSEG_PACKET, 0, packet_size + CHECKSUM_SIZE);
+	CalculateChecksums(cmdSuccess);
+
+	bytes_sent = XUartPs_Send(&Uart_PS, (u8 *)cmdSuccess, (CCSDS_HEADER_FULL + packet_size + CHECKSUM_SIZE));
+	if(bytes_sent == (CCSDS_HEADER_FULL + packet_size + CHECKSUM_SIZE))
+		status = CMD_SUCCESS;
+	else
+		status = CMD_FAILURE;
+
+	return status;
+}
+
+/**
+ * Report the DAQ loop stage profile from the current or most recent run in a SUCCESS packet.
+ * The payload is the command, the data cache mode of the run (DCACHE_0/1, see DAQ_OPT_DCACHE),
+ *  then one line per stage, DAQ_STAGE_# order:
+ * 	STAGE_COUNT_MIN_MAX_MEAN_BIN0_..._BIN7
+ * 	times are in microseconds, see DAQStatsGetStageHistBin() for the histogram bins
+ *  and last the queue line, the high-water mark and the overflows of each queue of the run:
+ * 	QUEUES_EVTHW_EVTOVF_CPSHW_CPSOVF_RAWHW_RAWOVF
+ *
+ * @param Uart_PS	Pointer to the instance of the UART which will
+ * 					transmit the packet to the spacecraft.
+ *
+ * @return	CMD_SUCCESS or CMD_FAILURE depending on if we sent out
+ * 			the correct number of bytes with the packet.
+ */
+int reportProfile(XUartPs Uart_PS)
+{
+	int status = 0;
+	int bytes_sent = 0;
+	int packet_size = 0;	//Don't record the size of the CCSDS header with this variable
+	int space_left = 0;
+	int i_sprintf_ret = 0;
+	int stage = 0;
+	int bin = 0;
+	unsigned char profile_buff[TELEMETRY_MAX_SIZE] = "";
+
+	space_left = TELEMETRY_MAX_SIZE - CCSDS_HEADER_FULL - CHECKSUM_SIZE;
+	i_sprintf_ret = snprintf((char *)(&profile_buff[11]), space_left, "%s\n", GetLastCommand());
+	if(i_sprintf_ret != (int)GetLastCommandSize())
+		return CMD_FAILURE;
+	packet_size += i_sprintf_ret;
+	space_left = TELEMETRY_MAX_SIZE - CCSDS_HEADER_FULL - CHECKSUM_SIZE - packet_size;
+	i_sprintf_ret = snprintf((char *)(&profile_buff[11 + packet_size]), space_left, "DCACHE_%d\n", GetRunDCacheMode());
+	if(i_sprintf_ret <= 0 || i_sprintf_ret >= space_left)
+		return CMD_FAILURE;
+	packet_size += i_sprintf_ret;
+	for(stage = 0; stage < DAQ_NUM_STAGES; stage++)
+	{
+		space_left = TELEMETRY_MAX_SIZE - CCSDS_HEADER_FULL - CHECKSUM_SIZE - packet_size;
+		i_sprintf_ret = snprintf((char *)(&profile_buff[11 + packet_size]), space_left, "%d_%u_%u_%u_%u", stage,
+				DAQStatsGetStageCount(stage), DAQStatsGetStageMinUs(stage), DAQStatsGetStageMaxUs(stage), DAQStatsGetStageMeanUs(stage));
+		if(i_sprintf_ret <= 0 || i_sprintf_ret >= space_left)
+			return CMD_FAILURE;
+		packet_size += i_sprintf_ret;
+		for(bin = 0; bin < DAQ_PROFILE_BINS; bin++)
+		{
+			space_left = TELEMETRY_MAX_SIZE - CCSDS_HEADER_FULL - CHECKSUM_SIZE - packet_size;
+			i_sprintf_ret = snprintf((char *)(&profile_buff[11 + packet_size]), space_left, "_%u", DAQStatsGetStageHistBin(stage, bin));
+			if(i_sprintf_ret <= 0 || i_sprintf_ret >= space_left)
+				return CMD_FAILURE;
+			packet_size += i_sprintf_ret;
+		}
+		space_left = TELEMETRY_MAX_SIZE - CCSDS_HEADER_FULL - CHECKSUM_SIZE - packet_size;
+		if(space_left < 2)
+			return CMD_FAILURE;
+		profile_buff[11 + packet_size] = '\n';
+		packet_size++;
+	}
+	space_left = TELEMETRY_MAX_SIZE - CCSDS_HEADER_FULL - CHECKSUM_SIZE - packet_size;
+	i_sprintf_ret = snprintf((char *)(&profile_buff[11 + packet_size]), space_left, "QUEUES_%u_%u_%u_%u_%u_%u\n",
+			GetEVTQueueHighWater(), GetEVTQueueOverflows(), GetCPSQueueHighWater(), GetCPSQueueOverflows(),
+			GetRawQueueHighWater(), GetRawQueueOverflows());
+	if(i_sprintf_ret <= 0 || i_sprintf_ret >= space_left)
+		return CMD_FAILURE;
+	packet_size += i_sprintf_ret;
+
+	PutCCSDSHeader(profile_buff, APID_CMD_SUCC, GF_UNSEG_PACKET, 0, packet_size + CHECKSUM_SIZE);
+	CalculateChecksums(profile_buff);
+
+	bytes_sent = SendPacket(Uart_PS, profile_buff, CCSDS_HEADER_FULL + packet_size + CHECKSUM_SIZE);
+	if(bytes_sent == (CCSDS_HEADER_FULL + packet_size + CHECKSUM_SIZE))
+		status = CMD_SUCCESS;
+	else
+		status = CMD_FAILURE;
+
+	return status;
+}
+
 /* Function to calculate all four checksums for CCSDS packets
  * This function calculates the Simple, Fletcher, and BCT checksums
  *  by looping over the bytes within the packet after the sync marker.
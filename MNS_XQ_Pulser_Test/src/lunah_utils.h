@@ -16,6 +16,8 @@
 #include "ReadCommandType.h"	//gives access to last command strings
 #include "lunah_defines.h"
 #include "LI2C_Interface.h"		//talk to I2C devices (temperature sensors)
+#include "DAQStatistics.h"		//DAQ dead time and buffer accounting for SOH
+#include "MirrorFiles.h"		//SD card 1 mirror status
 
 #define IIC_SLAVE_ADDR2		0x4B	//Temp sensor on digital board
 #define IIC_SLAVE_ADDR3		0x48	//Temp sensor on the analog board
@@ -23,11 +25,11 @@
 
 #define TAB_CHAR_CODE		9
 #define NEWLINE_CHAR_CODE	10
-#define SOH_PACKET_LENGTH	93	//56
+#define SOH_PACKET_LENGTH	157	//149	//113	//93	//56
 #define TEMP_PACKET_LENGTH	19
 #define	TX_FILE_STRING_BUFF_SIZE	100
 #define CMD_BUFFER_SIZE		100
-#define	SOH_BUFFER_SIZE		150
+#define	SOH_BUFFER_SIZE		170
 
 // prototypes
 void InitStartTime( void );
@@ -49,6 +51,8 @@ int report_SOH(XIicPs * Iic, XTime local_time, XUartPs Uart_PS, int packet_type)
 void PutCCSDSHeader(unsigned char * SOH_buff, int packet_type, int group_flags, int sequence_count, int length);
 int reportSuccess(XUartPs Uart_PS, int report_filename);
 int reportFailure(XUartPs Uart_PS);
+int reportMirrorStatus(XUartPs Uart_PS);
+int reportProfile(XUartPs Uart_PS);
 void CalculateChecksums(unsigned char * packet_array);
 int CalculateDataFileChecksum(XUartPs Uart_PS, char * RecvBuffer, int file_type, int id_num, int run_num, int set_num);
 int DeleteFile( XUartPs Uart_PS, char * RecvBuffer, int sd_card_number, int file_type, int id_num, int run_num, int set_num );
@@ -50,6 +50,14 @@
  *
  * 1-22-2020
  * The boot files created at 12:30pm are Version 7.1
+ *
+ * 10-17-2026
+ * The L1/L2 data caches stay disabled at boot. A DAQ run may turn them on for its duration with
+ *  DAQ_OPT_DCACHE, they are turned back off when the run returns. Until MNS_PROFILE numbers from
+ *  the flight hardware show the speedup, the default is DCACHE_OFF.
+ * Anything the DMA writes is invalidated before the CPU reads it (see DMAFinishTransfer()), so the
+ *  landing zones are correct in either mode. The SD driver (xsdps) already flushes/invalidates the
+ *  buffers it hands to its ADMA engine, so FatFs buffers need no extra maintenance.
  */
 
 #include "main.h"
@@ -60,7 +68,7 @@ int main()
 
 	init_platform();		//Maybe we dropped out important init functions?
 	ps7_post_config();
-	Xil_DCacheDisable();	// Disable the L1/L2 data caches
+	Xil_DCacheDisable();	// Disable the L1/L2 data caches, see DAQ_OPT_DCACHE
 	InitializeAXIDma();		// Initialize the AXI DMA Transfer Interface
 
 	status = InitializeInterruptSystem(XPAR_PS7_SCUGIC_0_DEVICE_ID);
@@ -198,7 +206,6 @@ int main()
 	int DAQ_run_number = 0;		//run number value for file names, tracks the number of runs per POR
 	int	menusel = 99999;		//case select variable for polling
 	FIL *cpsDataFile;			//create FIL pointers to check and make sure that the DAQ files were closed out
-	FIL *evtDataFile;
 	// ******************* WF Data Product Variables *******************//
 	int valid_data = 0;		//local test variable for WF
 	int numWFs = 0;
@@ -237,7 +244,7 @@ int main()
 			menusel = 99999;
 			menusel = ReadCommandType(RecvBuffer, &Uart_PS);	//Check for user input
 
-			if ( menusel >= -1 && menusel <= 15 )	//let all input in, including errors, so we can report them //we are not handling break, end, start, overflow by keeping this to 15...
+			if ( (menusel >= -1 && menusel <= 15) || menusel == DAQCFG_CMD || menusel == MIRROR_CMD || menusel == MIRRORSTAT_CMD || menusel == PROFILE_CMD )	//let all input in, including errors, so we can report them //we are not handling break, end, start, overflow by keeping this to 15...
 			{
 				//we found a valid LUNAH command or input was bad (-1)
 				//log the command issued, unless it is an error
@@ -247,6 +254,8 @@ int main()
 			}
 			//check to see if it is time to report SOH information, 1 Hz
 			CheckForSOH(&Iic, Uart_PS);
+			//copy finished data products to SD card 1, rate limited, only while idle
+			MirrorService();
 		}//END TEMP ASU TESTING LOOP
 
 		//MAIN MENU OF FUNCTIONS
@@ -257,6 +266,7 @@ int main()
 			reportFailure(Uart_PS);
 			break;
 		case DAQ_CMD:
+			MirrorPause();	//no mirror files stay open through the run
 			Xil_Out32(XPAR_AXI_GPIO_14_BASEADDR, 4);	//set processed data mode
 			Xil_Out32 (XPAR_AXI_GPIO_7_BASEADDR, 1);	//enable 5V to analog board
 			//set all the configuration parameters
@@ -337,9 +347,19 @@ int main()
 						done = 1;
 						reportSuccess(Uart_PS, 0);
 						break;
+					case DAQCFG_CMD:
+						//the run options may still be changed until the run starts
+						done = 0;
+						status = SetDAQOption(GetIntParam(1), GetIntParam(2));
+						if(status == CMD_SUCCESS)
+							reportSuccess(Uart_PS, 0);
+						else
+							reportFailure(Uart_PS);
+						break;
 					case START_CMD:
 						SetRealTime(GetRealTimeParam());
 						status = DataAcquisition(&Iic, Uart_PS, RecvBuffer, GetIntParam(1));
+						Xil_DCacheDisable();	//the run may have turned the data caches on, this flushes them first
 						//we will return in three ways:
 						// BREAK (0)	= failure
 						// time out (1) = success
@@ -377,9 +397,9 @@ int main()
 			cpsDataFile = GetCPSFilePointer();	//check the FIL pointers created by DAQ are closed safely
 			if (cpsDataFile->fs != NULL)
 				f_close(cpsDataFile);
-			evtDataFile = GetEVTFilePointer();
-			if (evtDataFile->fs != NULL)
-				f_close(evtDataFile);
+			CloseEVTFiles();	//trims the preallocated space, removes an unused next set file
+			//all of the run files are closed, hand the folder to the SD card 1 mirror
+			MirrorQueueFolder(GetFolderName());
 
 			//change directories back to the root directory
 			f_res = f_chdir("0:/");
@@ -400,6 +420,7 @@ int main()
 			SetRunNumber(0);
 			break;
 		case WF_CMD:
+			MirrorPause();	//no mirror files stay open through the run
 			//set processed data mode
 			if(GetIntParam(1) == 0)
 				Xil_Out32(XPAR_AXI_GPIO_14_BASEADDR, GetIntParam(1));	//get AA wfs = 0 //TRG wfs = 3
@@ -481,35 +502,27 @@ int main()
 				valid_data = Xil_In32 (XPAR_AXI_GPIO_11_BASEADDR);
 				if(valid_data == 1)
 				{
-					//init/start MUX to transfer data between integrator modules and the DMA
-					Xil_Out32 (XPAR_AXI_GPIO_15_BASEADDR, 1);
-					Xil_Out32 (XPAR_AXI_DMA_0_BASEADDR + 0x48, DRAM_BASE);
-					Xil_Out32 (XPAR_AXI_DMA_0_BASEADDR + 0x58, 65536);
-					usleep(54);
-					//TODO: need to check a shared variable within the interrupt handler and this function
-					// to see if the transfer is completed
-					//This check would replace the sleep statement.
-
-					Xil_Out32 (XPAR_AXI_GPIO_15_BASEADDR, 0);
-					ClearBRAMBuffers();
-					Xil_DCacheInvalidateRange(DRAM_BASE, 65536);
-
-					array_index = 0;
-					dram_addr = DRAM_BASE;
-					while(dram_addr < DRAM_CEILING)
+					//start the transfer, then wait for the interrupt handler to tell us it completed
+					DMAStartTransfer(DRAM_BASE);
+					if(DMAWaitForTransfer() == CMD_SUCCESS)
 					{
-						//TODO: cast these 32-bit values as unsigned 16-bit values so we save space and packets, etc.
-						wf_data[array_index] = Xil_In32(dram_addr);
-						dram_addr += 4;
-						array_index++;
-					}
+						array_index = 0;
+						dram_addr = DRAM_BASE;
+						while(dram_addr < DRAM_CEILING)
+						{
+							//TODO: cast these 32-bit values as unsigned 16-bit values so we save space and packets, etc.
+							wf_data[array_index] = Xil_In32(dram_addr);
+							dram_addr += 4;
+							array_index++;
+						}
 
-					numWFs++;
-					//have the WF, save to file //WFData
-					//NOTE: the values from the DRAM are 16 bit numbers written into 32 bit fields - the LSBs are where the values are stored
-					f_res = f_write(&WFData, wf_data, DATA_BUFFER_SIZE * sizeof(unsigned int), &numBytesWritten);
-					if(f_res != FR_OK)
-						xil_printf("3 write fail WF\n");
+						numWFs++;
+						//have the WF, save to file //WFData
+						//NOTE: the values from the DRAM are 16 bit numbers written into 32 bit fields - the LSBs are where the values are stored
+						f_res = f_write(&WFData, wf_data, DATA_BUFFER_SIZE * sizeof(unsigned int), &numBytesWritten);
+						if(f_res != FR_OK)
+							xil_printf("3 write fail WF\n");
+					}
 				}
 
 				//check for SOH
@@ -536,6 +549,7 @@ int main()
 			} //end of While(numWFs < #)
 
 			f_close(&WFData);
+			MirrorQueueFolder(wf_run_folder);
 
 			//change directories back to the root directory
 			f_res = f_chdir("0:/");
@@ -735,6 +749,39 @@ int main()
 			else
 				reportFailure(Uart_PS);
 			break;
+		case DAQCFG_CMD:
+			//set one of the DAQ run options
+			//intParam1 = option number
+			//intParam2 = option value
+			status = SetDAQOption(GetIntParam(1), GetIntParam(2));
+			//Determine SUCCESS or FAILURE
+			if(status)
+				reportSuccess(Uart_PS, 0);
+			else
+				reportFailure(Uart_PS);
+			break;
+		case MIRROR_CMD:
+			//set the SD card 1 mirror rate
+			//intParam1 = KiB per second, 0 = off
+			status = MirrorSetRate(GetIntParam(1));
+			//Determine SUCCESS or FAILURE
+			if(status)
+				reportSuccess(Uart_PS, 0);
+			else
+				reportFailure(Uart_PS);
+			break;
+		case MIRRORSTAT_CMD:
+			//report how far behind the SD card 1 mirror is
+			status = reportMirrorStatus(Uart_PS);
+			if(status == CMD_FAILURE)
+				reportFailure(Uart_PS);
+			break;
+		case PROFILE_CMD:
+			//report the DAQ loop stage profile from the most recent run
+			status = reportProfile(Uart_PS);
+			if(status == CMD_FAILURE)
+				reportFailure(Uart_PS);
+			break;
 		case INPUT_OVERFLOW:
 			//too much input
 			//TODO: Handle this problem here and in ReadCommandType
@@ -820,13 +867,15 @@ int InitializeInterruptSystem(u16 deviceID) {
  *
  *  We have the DMA in Direct Register Mode with Interrupt on Complete enabled.
  *  This means that an interrupt is generated on the completion of a transfer.
- *  The interrupt handler writes to the DMA status register to clear the
+ *  The interrupt handler writes to the DMA status register to clear the interrupt, then
+ *  tells DMAControl that the transfer is complete so the acquisition loop can use the data.
+ *  During DAQ, DMAControl re-arms the DMA with the next landing zone from here.
  */
 void InterruptHandler (void ) {
 	u32 tmpValue = 0;
 	tmpValue = Xil_In32(XPAR_AXI_DMA_0_BASEADDR + 0x34);	//Read the DMA status register
-	tmpValue |= 0x1000;							//bit 12 is write-to-clear, this acknowledges the interrupt generated by IOC
-	Xil_Out32 (XPAR_AXI_DMA_0_BASEADDR + 0x34, tmpValue);	//write to the DMA status register
+	Xil_Out32 (XPAR_AXI_DMA_0_BASEADDR + 0x34, tmpValue | 0x1000);	//bit 12 is write-to-clear, this acknowledges the interrupt generated by IOC
+	DMASetTransferComplete(tmpValue);			//acknowledge first, during DAQ this may start the next transfer
 
 
 }
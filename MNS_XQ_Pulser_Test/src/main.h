@@ -35,6 +35,8 @@
 #include "LogFileControl.h"
 #include "DataAcquisition.h"
 #include "RecordFiles.h"
+#include "DMAControl.h"
+#include "MirrorFiles.h"
 
 //Global Interrupt Control Variables
 //These need to be global for interrupts to be handled appropriately within the system
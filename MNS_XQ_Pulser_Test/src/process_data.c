@@ -10,23 +10,101 @@
 //File Scope Variables and Buffers
 static int evt_iter;										//event buffer iterator
 static const GENERAL_EVENT_TYPE evtEmptyStruct;				//use this to reset the holder struct each iteration
-static GENERAL_EVENT_TYPE event_buffer[EVENT_BUFFER_SIZE];	//buffer to store events //2048 * 8 bytes = 16384 bytes
+static EVT_BLOCK_TYPE m_evt_block;							//the EVT block being filled, header and events //8 + 8192 * 8 bytes
+static int m_evt_batch_events = EVT_DEFAULT_BATCH_BUFFERS * VALID_BUFFER_SIZE;	//events in the EVT block for this run
+static int m_evt_filter = EVT_FILTER_ALL;					//which data events go in the EVT block, EVT_FILTER_#
+static int m_filter_energy_min;								//the EVT_FILTER_REGION bins, inclusive
+static int m_filter_energy_max = TWODH_X_BINS - 1;
+static int m_filter_psd_min;
+static int m_filter_psd_max = TWODH_Y_BINS - 1;
 static unsigned int m_first_event_time_FPGA;				//the first event time which needs to be written into every data product header
+static CPS_EVENT_STRUCT_TYPE m_cps_record_storage[CPS_RECORD_QUEUE_DEPTH];	//finished CPS records waiting for the I/O stage
+static SPSC_RING_TYPE m_cps_record_ring;					//hands CPS records from the processing stage to the I/O stage
+static EVENT_QUALITY_TYPE m_evt_quality;					//rejected and flagged events for the current (or most recent) run
+
 /*
- * Helper function to allow external functions to grab the EVTs buffer and write it to SD
+ * Helper function to allow external functions to grab the EVTs block and write it to SD.
+ * The block header is filled in with the number of events in the block so far, only
+ *  GetEVTsBlockBytes() of the block need to be written.
  */
-GENERAL_EVENT_TYPE * GetEVTsBufferAddress( void )
+EVT_BLOCK_TYPE * GetEVTsBlock( void )
 {
-	return event_buffer;
+	m_evt_block.header.eventID1 = 0xBB;
+	m_evt_block.header.eventID2 = 0xBB;
+	m_evt_block.header.eventID3 = 0xBB;
+	m_evt_block.header.eventID4 = 0xBB;
+	m_evt_block.header.num_events = (unsigned int)evt_iter;
+	return &m_evt_block;
 }
 
-
+/*
+ * Clear the events buffer. This only needs to happen once at the start of a run, the events
+ *  past evt_iter are never written.
+ */
 void ResetEVTsBuffer( void )
 {
-	memset(event_buffer, '\0', sizeof(event_buffer));
+	memset(&m_evt_block, '\0', sizeof(m_evt_block));
 	return;
 }
 
+/*
+ * Set how many FPGA buffers worth of events make up one EVT block. Only the front of the events
+ *  buffer is used, the rest is there for the largest batch depth.
+ *
+ * @param	(int) the number of buffers per EVT block, 1 -> EVT_MAX_BATCH_BUFFERS
+ *
+ * @return	None
+ */
+void SetEVTsBatchSize( int num_buffers )
+{
+	if(num_buffers < 1 || num_buffers > EVT_MAX_BATCH_BUFFERS)
+		num_buffers = EVT_DEFAULT_BATCH_BUFFERS;
+	m_evt_batch_events = num_buffers * VALID_BUFFER_SIZE;
+	return;
+}
+
+/*
+ * Set which data events are stored in the EVT blocks for this run. Every data event is still
+ *  tallied for CPS and the 2DH, the filter only decides what goes to the EVT file.
+ *
+ * @param	(int) the filter, EVT_FILTER_#, anything else keeps every event
+ * @param	(int) lowest energy bin kept for EVT_FILTER_REGION
+ * @param	(int) highest energy bin kept for EVT_FILTER_REGION
+ * @param	(int) lowest PSD bin kept for EVT_FILTER_REGION
+ * @param	(int) highest PSD bin kept for EVT_FILTER_REGION
+ *
+ * @return	None
+ */
+void SetEVTsFilter( int filter, int energy_min, int energy_max, int psd_min, int psd_max )
+{
+	if(filter != EVT_FILTER_NEUTRONS && filter != EVT_FILTER_REGION)
+		filter = EVT_FILTER_ALL;
+	m_evt_filter = filter;
+	m_filter_energy_min = energy_min;
+	m_filter_energy_max = energy_max;
+	m_filter_psd_min = psd_min;
+	m_filter_psd_max = psd_max;
+	return;
+}
+
+/*
+ * Getter function for the number of bytes in the EVT block as filled so far, the block header and
+ *  the events. This is what gets written to the EVT file.
+ */
+int GetEVTsBlockBytes( void )
+{
+	return (int)sizeof(EVT_BLOCK_HEADER_TYPE) + evt_iter * (int)sizeof(GENERAL_EVENT_TYPE);
+}
+
+/*
+ * Getter function for the number of bytes in a full EVT block for this run, use this to size
+ *  anything which holds a block.
+ */
+int GetEVTsMaxBlockBytes( void )
+{
+	return (int)sizeof(EVT_BLOCK_HEADER_TYPE) + m_evt_batch_events * (int)sizeof(GENERAL_EVENT_TYPE);
+}
+
 void ResetEVTsIterator( void )
 {
 	evt_iter = 0;
@@ -39,6 +117,206 @@ unsigned int GetFirstEventTime( void )
 	return m_first_event_time_FPGA;
 }
 
+/*
+ * Empty the queue of finished CPS records. Call this before a run starts, while nothing is
+ *  pushing to or reading from the queue.
+ */
+void ResetCPSRecordQueue( void )
+{
+	SPSCRingInit(&m_cps_record_ring, m_cps_record_storage, sizeof(CPS_EVENT_STRUCT_TYPE), CPS_RECORD_QUEUE_DEPTH);
+	return;
+}
+
+/*
+ * Helper function to allow the I/O stage to collect the CPS records which ProcessData() has finished.
+ * ProcessData() is the only producer, the DAQ loop which writes the CPS file is the only consumer.
+ */
+SPSC_RING_TYPE * GetCPSRecordQueue( void )
+{
+	return &m_cps_record_ring;
+}
+
+
+/*
+ * Zero the event quality accounting at the start of a DAQ run.
+ * The values are kept after the run ends so that SOH can still report them.
+ */
+void ResetEventQuality( void )
+{
+	memset(&m_evt_quality, 0, sizeof(m_evt_quality));
+	return;
+}
+
+/*
+ * Helper function to allow SOH and the file footers to read the event quality accounting.
+ */
+EVENT_QUALITY_TYPE * GetEventQuality( void )
+{
+	return &m_evt_quality;
+}
+
+/*
+ * Move the CPS data product up to the 1 second interval which holds this event time. Each
+ *  interval which finishes before it is handed to the I/O stage and the counts start over.
+ * Both data and pulser events come through here before they are counted, so each one lands in
+ *  the interval its own time belongs to.
+ *
+ * @param	(unsigned int) the FPGA time from the event
+ *
+ * @return	None
+ */
+static void AdvanceCPSInterval( unsigned int time )
+{
+	//if the first event time has not been recorded, then set one //this allows us to function without a false event
+	if(cpsGetFirstEventTime() == 0)
+		cpsSetFirstEventTime(time);
+	//loop recording the CPS events until we don't need to //this only happens when the current event belongs to the next one-second time interval
+	while(cpsCheckTime(time) == TRUE)
+	{
+		//the queue is only drained between buffers, a gap of more than a queue's worth of seconds
+		// in one buffer would fill it, so the waiting records are written out here rather than lost
+		if(SPSCRingCount(&m_cps_record_ring) >= CPS_RECORD_QUEUE_DEPTH - 1)
+			WriteCPSRecords(1);
+		//hand the finished record to the I/O stage, it is written to the CPS file from there
+		SPSCRingPush(&m_cps_record_ring, cpsGetEvent());
+		//reset the neutron counts for the CPS data product
+		CPSResetCounts();
+	}
+
+	return;
+}
+
+/*
+ * Process one data event which has already passed the checks in ProcessData(). The event is
+ *  tallied for CPS and the 2DH, then packed into the next open spot of the EVTs buffer if it
+ *  passes the EVT filter, see SetEVTsFilter().
+ *
+ * @param	(unsigned int *) the event, starting at the 111111 header word
+ *
+ * @return	(unsigned int) the event number, to check the next event against
+ */
+static unsigned int DecodeEvent( unsigned int * event )
+{
+	int m_ret = 0;	//for 2DH tallies
+	int m_energy_bin = 0;
+	int m_psd_bin = 0;
+	unsigned int m_tagging_bit = 0;
+	unsigned int m_event_number_holder = 0;
+	unsigned int m_pmt_ID_holder = 0;
+	unsigned int m_FPGA_time_holder = 0;
+	int m_bin_flags = 0;
+	int m_baseline_channel = 0;
+	unsigned long long m_baseline_sum = 0;
+	GENERAL_EVENT_TYPE event_holder = evtEmptyStruct;
+
+	AdvanceCPSInterval(event[1]);
+	CPSAddDataEvent();
+
+	//assign this value to the PMT ID so that we have something to compare with the defined PMT hit ID
+	m_pmt_ID_holder = event[3] & 0x0F;
+	//add this event to the baseline moving average for its PMT
+	m_baseline_channel = BaselineGetChannel(m_pmt_ID_holder);
+	m_baseline_sum = BaselineUpdate(m_baseline_channel, event[4]);
+	//calculate the "bin space" values of the energy and PSD
+	m_bin_flags = BinningFindBins(m_baseline_channel, m_baseline_sum, event[5], event[6], event[7], &m_energy_bin, &m_psd_bin);
+	if(m_bin_flags & BINNING_BAD_PSD)
+	{
+		//TODO: PSD value not good
+		m_evt_quality.bad_psd++;
+	}
+	if(m_bin_flags & BINNING_ENERGY_OUT)
+		m_evt_quality.energy_out_of_range++;
+	if(m_pmt_ID_holder == PMT_ID_0 || m_pmt_ID_holder == PMT_ID_1 || m_pmt_ID_holder == PMT_ID_2 || m_pmt_ID_holder == PMT_ID_3)
+	{
+		//process the event for CPS
+		m_tagging_bit = CPSUpdateTallies(m_energy_bin, m_psd_bin, m_pmt_ID_holder);
+		if(m_tagging_bit < 0)
+		{
+			//TODO: handle the error in the CPS neutron counts
+			// -1 = indicates an error with the PMT hit ID
+		}
+
+		//process the event for 2DH
+		m_ret = Tally2DH(m_energy_bin, m_psd_bin, m_pmt_ID_holder);
+		if(m_ret != 1)
+		{
+			//TODO: identify what can go wrong and handle a bad tally
+			// 0 is the bins were not in the 2DGH
+			//-1 is the PMT ID indicated a multi-hit
+		}
+	}
+	else
+	{
+		//mark the event as a bad event //we are not interested in events with PMT ID of 0 or multi-hit events
+		m_evt_quality.multi_hit++;
+	}
+
+	m_event_number_holder = (event[3]	& 0xFFF0) >> 4;
+	//the event has been counted, only keep it in the EVT data if it passes the filter
+	if((m_evt_filter == EVT_FILTER_NEUTRONS && m_tagging_bit != 1)
+			|| (m_evt_filter == EVT_FILTER_REGION
+				&& (m_energy_bin < m_filter_energy_min || m_energy_bin > m_filter_energy_max
+					|| m_psd_bin < m_filter_psd_min || m_psd_bin > m_filter_psd_max)))
+	{
+		m_evt_quality.filtered_events++;
+		return m_event_number_holder;
+	}
+
+	event_holder.field0 = 0xFF;
+	event_holder.field1 |= (m_pmt_ID_holder		& 0x000F) << 4;
+	event_holder.field1 |= (unsigned char)((m_event_number_holder	& 0x0F00) >> 8);
+	event_holder.field2 |= (unsigned char)( m_event_number_holder	& 0x0FF);
+	event_holder.field3 |= (unsigned char)((m_energy_bin	& 0x1FE) >> 1);
+	event_holder.field4 |= (unsigned char)((m_energy_bin	& 0x001) << 7);
+	event_holder.field4 |= (unsigned char)((m_psd_bin	 	& 0x3F) << 1);
+	event_holder.field4 |= (unsigned char)( m_tagging_bit 	& 0x01);
+	m_FPGA_time_holder = ((event[1] & 0xFFFFFF00) >> 8);
+	event_holder.field5 = (unsigned char)((m_FPGA_time_holder & 0xFF0000) >> 16);
+	event_holder.field6 = (unsigned char)((m_FPGA_time_holder & 0x00FF00)>> 8);
+	event_holder.field7 = (unsigned char)( m_FPGA_time_holder & 0x0000FF);
+
+	m_evt_block.events[evt_iter] = event_holder;
+	evt_iter++;
+
+	return m_event_number_holder;
+}
+
+/*
+ * Scan forward from iter for the next word which could start an event, this is how ProcessData()
+ *  gets back in step after junk or a partial event in the buffer.
+ * Each word is compared against all three event headers. A data event header is also passed over
+ *  if its integrals are out of order, that event would be thrown out anyway and checking it here
+ *  needs no CPS or event number state. Anything else which looks like a header is left for the
+ *  switch in ProcessData() to deal with.
+ *
+ * @param	(unsigned int *) the data buffer
+ * @param	(int) where in the buffer to start looking
+ *
+ * @return	(int) the index of the next possible header, DATA_BUFFER_SIZE if there is none
+ */
+static int FindNextHeader( unsigned int * data_raw, int iter )
+{
+	unsigned int word = 0;
+
+	while(iter < DATA_BUFFER_SIZE)
+	{
+		word = data_raw[iter];
+		if(word == 111111)
+		{
+			//too close to the end of the buffer to check, or a repeated header, let the switch handle it
+			if(iter >= (DATA_BUFFER_SIZE - 7) || data_raw[iter+1] == 111111)
+				return iter;
+			if((data_raw[iter+4] < data_raw[iter+5]) && (data_raw[iter+5] < data_raw[iter+6]) && (data_raw[iter+6] < data_raw[iter+7]))
+				return iter;
+			m_evt_quality.rejected_ordering++;
+		}
+		else if(word == 0x4001B207 || word == 0x8001B207)
+			return iter;
+		iter++;
+	}
+
+	return iter;
+}
 
 /*
  * This function will be called after we read in a buffer of valid data from the FPGA.
@@ -46,6 +324,9 @@ unsigned int GetFirstEventTime( void )
  *  is processed to pull the PSD and energy information out. We identify it the event
  *  is within the current 1 second CPS interval, as well as bin the events into a
  *  2-D histogram which is reported at the end of a run.
+ * This is the processing stage of DAQ and does no file I/O. Finished CPS records are pushed
+ *  onto the CPS record queue and events are left in the EVTs buffer for the I/O stage to write,
+ *  so that an SD card stall never holds up event parsing.
  *
  * @param	A pointer to the data buffer
  *
@@ -55,49 +336,15 @@ int ProcessData( unsigned int * data_raw )
 {
 	bool valid_event = FALSE;	//Unused (4/8/2019) //could use this to check for reset request //otherwise probably delete
 	int iter = 0;
-	int m_ret = 0;	//for 2DH tallies
 	int m_events_processed = 0;
-	int m_energy_bin = 0;
-	int m_psd_bin = 0;
-	unsigned int m_tagging_bit = 0;
-	unsigned int num_bytes_written = 0;
+	int m_next_header = 0;
+	unsigned int m_words_skipped = 0;	//words passed over without finding an event, this buffer
 	unsigned int m_event_number_holder = 0;
-	unsigned int m_pmt_ID_holder = 0;
-	unsigned int m_FPGA_time_holder = 0;
-	unsigned int m_bad_event = 0;
-	double m_baseline_int = 0.0;
-	double m_short_int = 0.0;
-	double m_long_int = 0.0;
-	double m_full_int = 0.0;
-	double bl_avg = 0.0;
-	double bl1 = 0.0;
-	double bl2 = 0.0;
-	double bl3 = 0.0;
-	double bl4 = 0.0;
-	double si = 0.0;
-	double li = 0.0;
-	double fi = 0.0;
-	double psd = 0.0;
-	FRESULT f_res = FR_OK;
 	GENERAL_EVENT_TYPE event_holder = evtEmptyStruct;
 
-	//get the integration times
-	m_baseline_int = (double)GetBaselineInt();
-	m_short_int = (double)GetShortInt();
-	m_long_int = (double)GetLongInt();
-	m_full_int = (double)GetFullInt();
-
-	FIL *cpsDataFile = GetCPSFilePointer();
-	if (cpsDataFile == NULL)
-	{
-		//TODO: handle error with pointer
-		xil_printf("error getting FIL pointer 6\n");
-	}
-
 	while(iter < DATA_BUFFER_SIZE)
 	{
 		event_holder = evtEmptyStruct;	//reset event structure
-		m_tagging_bit = 0;
 
 		switch(data_raw[iter])
 		{
@@ -116,120 +363,33 @@ int ProcessData( unsigned int * data_raw )
 					if((data_raw[iter+4] < data_raw[iter+5]) && (data_raw[iter+5] < data_raw[iter+6]) && (data_raw[iter+6] < data_raw[iter+7]))
 					{
 						valid_event = TRUE;
-						//if the first event time has not been recorded, then set one //this allows us to function without a false event
-						if(cpsGetFirstEventTime() == 0)
-							cpsSetFirstEventTime(data_raw[iter+1]);
-						//loop recording the CPS events until we don't need to //this only happens when the current event belongs to the next one-second time interval
-						while(cpsCheckTime(data_raw[iter+1]) == TRUE)
-						{
-							f_res = f_write(cpsDataFile, (char *)cpsGetEvent(), sizeof(CPS_EVENT_STRUCT_TYPE), &num_bytes_written);
-							if(f_res != FR_OK || num_bytes_written != sizeof(CPS_EVENT_STRUCT_TYPE))
-							{
-								//TODO:handle error with writing
-								xil_printf("error writing 4\n");
-							}
-							f_res = f_sync(cpsDataFile);
-							if(f_res != FR_OK || num_bytes_written != sizeof(CPS_EVENT_STRUCT_TYPE))
-							{
-								//TODO:handle error with writing
-								xil_printf("error writing 5\n");
-							}
-							//reset the neutron counts for the CPS data product
-							CPSResetCounts();
-						}
-
-						//calculate the moving average of the baseline integral
-						si = 0.0;	li = 0.0;	fi = 0.0;	psd = 0.0;
-						bl4 = bl3; bl3 = bl2; bl2 = bl1;
-						bl1 = (double)data_raw[iter+4] / (16.0 * m_baseline_int);
-						if(bl4 == 0.0)
-							bl_avg = bl1;
-						else
-							bl_avg = (bl4 + bl3 + bl2 + bl1) / 4.0;
-						//calculate the baseline corrected integrals from the event
-						si = ((double)data_raw[iter+5]) / (16.0) - (bl_avg * m_short_int);
-						li = ((double)data_raw[iter+6]) / (16.0) - (bl_avg * m_long_int);
-						fi = ((double)data_raw[iter+7]) / (16.0) - (bl_avg * m_full_int);
-
-						//li, si must be positive, li greater than si (ensures positive psd values and li != si)
-						if( li > 0 && si > 0 && li > si) //TODO: how much should we test here? //si != 0, li > si, si > 0 ?
-							psd = si / (li - si);
-						else
-						{
-							//TODO: PSD value not good
-							psd = 1.999;	//set to highest good bin
-							m_bad_event++;
-						}
-						//calculate the "bin space" values of the energy and PSD
-						m_energy_bin = (int)floor(fi / ((double)TWODH_ENERGY_MAX / (double)TWODH_X_BINS));
-						m_psd_bin = (int)floor(psd / ((double)TWODH_PSD_MAX / (double)TWODH_Y_BINS));
-						//generate the bin value to use
-						if(0 <= m_energy_bin && m_energy_bin < TWODH_X_BINS)
-							m_energy_bin &= 0x01FF;
-						else
-							m_energy_bin = 0x01FF;
-
-						if(0 <= m_psd_bin && m_psd_bin < TWODH_Y_BINS)
-							m_psd_bin &= 0x3F;	//move to 6 bits 10-11-2019
-						else
-							m_psd_bin = 0x3F;
-						//assign this value to the PMT ID so that we have something to compare with the defined PMT hit ID
-						m_pmt_ID_holder = data_raw[iter+3] & 0x0F;
-						if(m_pmt_ID_holder == PMT_ID_0 || m_pmt_ID_holder == PMT_ID_1 || m_pmt_ID_holder == PMT_ID_2 || m_pmt_ID_holder == PMT_ID_3)
-						{
-							//process the event for CPS
-							m_tagging_bit = CPSUpdateTallies(m_energy_bin, m_psd_bin, m_pmt_ID_holder);
-							if(m_tagging_bit < 0)
-							{
-								//TODO: handle the error in the CPS neutron counts
-								// -1 = indicates an error with the PMT hit ID
-							}
-
-							//process the event for 2DH
-							m_ret = Tally2DH(m_energy_bin, m_psd_bin, m_pmt_ID_holder);
-							if(m_ret != 1)
-							{
-								//TODO: identify what can go wrong and handle a bad tally
-								// 0 is the bins were not in the 2DGH
-								//-1 is the PMT ID indicated a multi-hit
-							}
-						}
-						else
-						{
-							//mark the event as a bad event //we are not interested in events with PMT ID of 0 or multi-hit events
-							m_bad_event++;
-						}
-
-						event_holder.field0 = 0xFF;
-						event_holder.field1 |= (m_pmt_ID_holder		& 0x000F) << 4;
-						m_event_number_holder = (data_raw[iter+3]	& 0xFFF0) >> 4;
-						event_holder.field1 |= (unsigned char)((m_event_number_holder	& 0x0F00) >> 8);
-						event_holder.field2 |= (unsigned char)( m_event_number_holder	& 0x0FF);
-						event_holder.field3 |= (unsigned char)((m_energy_bin	& 0x1FE) >> 1);
-						event_holder.field4 |= (unsigned char)((m_energy_bin	& 0x001) << 7);
-						event_holder.field4 |= (unsigned char)((m_psd_bin	 	& 0x3F) << 1);
-						event_holder.field4 |= (unsigned char)( m_tagging_bit 	& 0x01);
-						m_FPGA_time_holder = ((data_raw[iter+1] & 0xFFFFFF00) >> 8);
-						event_holder.field5 = (unsigned char)((m_FPGA_time_holder & 0xFF0000) >> 16);
-						event_holder.field6 = (unsigned char)((m_FPGA_time_holder & 0x00FF00)>> 8);
-						event_holder.field7 = (unsigned char)( m_FPGA_time_holder & 0x0000FF);
-
-						event_buffer[evt_iter] = event_holder;
-						evt_iter++;
+						m_event_number_holder = DecodeEvent(&data_raw[iter]);
 						iter += 8;
 						m_events_processed++;
 					}
 					else
+					{
 						valid_event = FALSE;
+						m_evt_quality.rejected_ordering++;
+					}
 				}
 				else
+				{
 					valid_event = FALSE;
+					m_evt_quality.rejected_event_number++;
+				}
 			}
 			else
+			{
 				valid_event = FALSE;
+				m_evt_quality.rejected_time++;
+			}
 
 			if(valid_event == FALSE)
+			{
 				iter++;
+				m_words_skipped++;
+			}
 			break;
 		case 1073852935:
 			//pulser event header //0x4001B207
@@ -240,6 +400,14 @@ int ProcessData( unsigned int * data_raw )
 				iter++;
 				break;	//skip out early
 			}
+			//the pulse moves the CPS interval, so its time has to pass the same check as a data event
+			if(data_raw[iter + 1] < cpsGetCurrentTime())
+			{
+				m_evt_quality.rejected_time++;
+				iter++;
+				m_words_skipped++;
+				break;
+			}
 			//if we see the event ID for a triggered event, just write the triggered event into the data stream
 			// then bump up the iterator value and keep going
 			event_holder.field0 = 0xEE;
@@ -247,15 +415,18 @@ int ProcessData( unsigned int * data_raw )
 			event_holder.field2 = 0xEE;
 			event_holder.field3 = 0xEE;
 			event_holder.field4 = 0xEE;
+			AdvanceCPSInterval(data_raw[iter + 1]);	//count the pulse in the interval its own time is in
 			//assume the time is in field 2, just like in the
 			event_holder.field5 = (unsigned char)(data_raw[iter + 1] >> 24);
 			event_holder.field6 = (unsigned char)(data_raw[iter + 1] >> 16);
 			event_holder.field7 = (unsigned char)(data_raw[iter + 1] >> 8);
 
-			event_buffer[evt_iter] = event_holder;
+			m_evt_block.events[evt_iter] = event_holder;
 			evt_iter++;
 			iter += 8;
 			m_events_processed++;
+			m_evt_quality.pulser_events++;
+			CPSAddPulserEvent();	//for the live time of this CPS interval
 			break;
 		case 2147594759:
 			//this is a false event //0x8001B207
@@ -282,30 +453,39 @@ int ProcessData( unsigned int * data_raw )
 				event_holder.field6 = (unsigned char)(data_raw[iter + 1] >> 16);
 				event_holder.field7 = (unsigned char)(data_raw[iter + 1] >> 8);
 
-				event_buffer[evt_iter] = event_holder;
+				m_evt_block.events[evt_iter] = event_holder;
 				evt_iter++;
 				iter += 8;
 				m_events_processed++;
+				m_evt_quality.false_events++;
 			}
 			else
+			{
 				iter++;
+				m_words_skipped++;
+			}
 			break;
 		default:
 			//this indicates that we miscounted our place in the buffer somewhere
 			//or there is junk in the buffer in the middle of an event
 			//TODO: handle a bad event or junk in the buffer
-			iter++;	//move past it, at least, we can sync back up by finding the 111111 again
+			//move past it to the next word which could be an event header
+			m_next_header = FindNextHeader(data_raw, iter + 1);
+			m_words_skipped += (unsigned int)(m_next_header - iter);
+			iter = m_next_header;
 			break;
 		}//END OF SWITCH ON RAW DATA
 
 		if(iter > (DATA_BUFFER_SIZE - EVT_EVENT_SIZE))	//will read past the array if iter goes above
 			break;
-		if(evt_iter >= EVENT_BUFFER_SIZE)	//we have run out of open events in the buffer
+		if(evt_iter >= m_evt_batch_events)	//we have run out of open events in the buffer
 			break;
 		if(m_events_processed >= VALID_BUFFER_SIZE)	//we have processed every event in the buffer (max of 512)
 			break;
 		//TODO: fully error check the buffering here
 	}//END OF WHILE
+	m_evt_quality.junk_words += m_words_skipped;
+	DAQStatsWordsSkipped(m_words_skipped);
 
 	//TODO: give this return value a meaning
 	return 0;
@@ -16,6 +16,10 @@
 #include "SetInstrumentParam.h"
 #include "CPSDataProduct.h"
 #include "TwoDHisto.h"
+#include "SPSCRing.h"
+#include "EventBinning.h"
+#include "BaselineTracker.h"
+#include "DAQStatistics.h"
 
 //the data from the FPGA are in the following format
 //event id = data_raw[iter]
@@ -27,6 +31,25 @@
 //long int = data_raw[iter+6]
 //full int = data_raw[iter+7]
 
+/*
+ * Event quality accounting for a DAQ run, what ProcessData() threw out and why.
+ * The rejected_# counters are data event headers which were found but failed a check, bad_psd,
+ *  multi_hit, and energy_out_of_range are events which were kept (they are in the EVT data) but
+ *  could not be fully binned or tallied. A rejected header also counts as a junk word.
+ */
+typedef struct {
+	unsigned int rejected_time;			//event time before the current CPS interval
+	unsigned int rejected_event_number;	//event number did not go up
+	unsigned int rejected_ordering;		//integrals out of order
+	unsigned int bad_psd;				//short/long integrals failed the PSD checks
+	unsigned int multi_hit;				//no PMT or more than one PMT hit, not tallied
+	unsigned int energy_out_of_range;	//energy outside of the 2DH
+	unsigned int junk_words;			//words skipped to find the next event
+	unsigned int pulser_events;
+	unsigned int false_events;
+	unsigned int filtered_events;		//data events left out of the EVT file by the EVT filter
+}EVENT_QUALITY_TYPE;
+
 typedef struct {
 	unsigned char field0;
 	unsigned char field1;
@@ -38,11 +61,37 @@ typedef struct {
 	unsigned char field7;
 }GENERAL_EVENT_TYPE;
 
+/*
+ * Each EVT block in the EVT file starts with this header and is followed by num_events events.
+ * Only the events which were filled are written, so ground tools use num_events to find the
+ *  next block header. The header is the same size as an event so the file stays in 8 byte records.
+ */
+typedef struct {
+	unsigned char eventID1;		//0xBB
+	unsigned char eventID2;		//0xBB
+	unsigned char eventID3;		//0xBB
+	unsigned char eventID4;		//0xBB
+	unsigned int num_events;	//events which follow this header
+}EVT_BLOCK_HEADER_TYPE;
+
+typedef struct {
+	EVT_BLOCK_HEADER_TYPE header;
+	GENERAL_EVENT_TYPE events[EVENT_BUFFER_SIZE];
+}EVT_BLOCK_TYPE;
+
 //function prototypes
-GENERAL_EVENT_TYPE * GetEVTsBufferAddress( void );
+EVT_BLOCK_TYPE * GetEVTsBlock( void );
 void ResetEVTsBuffer( void );
+void SetEVTsBatchSize( int num_buffers );
+void SetEVTsFilter( int filter, int energy_min, int energy_max, int psd_min, int psd_max );
+int GetEVTsBlockBytes( void );
+int GetEVTsMaxBlockBytes( void );
 void ResetEVTsIterator( void );
 unsigned int GetFirstEventTime( void );
+void ResetCPSRecordQueue( void );
+SPSC_RING_TYPE * GetCPSRecordQueue( void );
+void ResetEventQuality( void );
+EVENT_QUALITY_TYPE * GetEventQuality( void );
 int ProcessData( unsigned int * data_raw );
 
 #endif /* SRC_PROCESS_DATA_H_ */